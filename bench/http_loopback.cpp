@@ -0,0 +1,100 @@
+// Loopback load generator for `oui serve`: N client threads issue
+// one-request-per-connection GETs and report throughput and latency
+// percentiles. Start the server with the backend under test, e.g.
+//   oui serve --port 8080 --io uring &
+//   oui_bench_http 127.0.0.1 8080 4 20000
+// With stall-ms > 0 the first slow-threads clients (default: all) send half
+// of each request, wait stall-ms, then send the rest. A serial server stalls
+// everyone behind a slow client; a multiplexing one keeps serving the others:
+//   oui_bench_http 127.0.0.1 8080 64 200 /api/lookup?mac=00:1B:C5:00:00:01 20 8
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static bool send_all(int fd, const char* p, size_t n) {
+  return ::write(fd, p, n) == static_cast<ssize_t>(n);
+}
+
+static bool one_request(const sockaddr_in& addr, const std::string& req, int stallMs) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return false;
+  bool ok = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+  if (ok && stallMs > 0) {
+    const size_t half = req.size() / 2;
+    ok = send_all(fd, req.data(), half);
+    std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+    ok = ok && send_all(fd, req.data() + half, req.size() - half);
+  } else if (ok) {
+    ok = send_all(fd, req.data(), req.size());
+  }
+  char buf[4096];
+  size_t total = 0;
+  while (ok) {
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n <= 0) break;
+    total += static_cast<size_t>(n);
+  }
+  ::close(fd);
+  return ok && total > 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 5) {
+    std::fprintf(stderr, "usage: %s <host> <port> <threads> <requests-per-thread> [path] [stall-ms] [slow-threads]\n", argv[0]);
+    return 2;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(std::atoi(argv[2])));
+  if (inet_pton(AF_INET, argv[1], &addr.sin_addr) != 1) {
+    std::fprintf(stderr, "invalid host: %s\n", argv[1]);
+    return 2;
+  }
+  const int threads = std::max(1, std::atoi(argv[3]));
+  const int perThread = std::max(1, std::atoi(argv[4]));
+  const std::string path = argc > 5 ? argv[5] : "/api/lookup?mac=00:1B:C5:00:00:01";
+  const int stallMs = argc > 6 ? std::max(0, std::atoi(argv[6])) : 0;
+  const int slowThreads = argc > 7 ? std::max(0, std::atoi(argv[7])) : threads;
+  const std::string req = "GET " + path + " HTTP/1.1\r\nHost: bench\r\n\r\n";
+
+  std::vector<std::vector<double>> lat(static_cast<size_t>(threads));
+  std::atomic<int> errors{0};
+  const auto start = Clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      auto& mine = lat[static_cast<size_t>(t)];
+      mine.reserve(static_cast<size_t>(perThread));
+      for (int i = 0; i < perThread; i++) {
+        auto t0 = Clock::now();
+        if (!one_request(addr, req, t < slowThreads ? stallMs : 0)) errors++;
+        mine.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+      }
+    });
+  }
+  for (auto& w : workers) w.join();
+  const double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::vector<double> all;
+  for (auto& v : lat) all.insert(all.end(), v.begin(), v.end());
+  std::sort(all.begin(), all.end());
+  auto pct = [&](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+
+  std::printf("requests=%zu errors=%d elapsed=%.3fs rps=%.0f\n", all.size(), errors.load(), secs,
+              all.size() / secs);
+  std::printf("latency_us p50=%.1f p90=%.1f p99=%.1f max=%.1f\n", pct(0.50), pct(0.90), pct(0.99),
+              all.back());
+  return errors.load() ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+// Per-lookup latency of ManufDB::lookup for each way `oui serve` can hold
+// the tables: the hash index built by load(), a mapped image file (pages
+// faulted in on first use, like a shared-memory attach), and copies placed
+// by oui::place() with 4 KB pages, transparent huge pages and mlock.
+// Lookups hit random entries across the whole table. "first" is the first
+// 5000 lookups right after setup with the CPU caches flushed (the startup
+// window), "steady" a full pass afterwards. "lookup" is the whole
+// ManufDB::lookup the server calls (dominated by copying the result
+// strings), "find" only the table access.
+//   oui_bench_lookup data/manuf 200000
+#include "oui/compiled_db.h"
+#include "oui/manuf_db.h"
+#include "oui/placement.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static void flush_caches() {
+  static std::vector<char> junk(64u << 20);
+  for (size_t i = 0; i < junk.size(); i += 64) junk[i]++;
+}
+
+static constexpr size_t kFirst = 5000;
+
+template <typename F>
+static void run_pass(const char* name, const char* pass, const uint64_t* macs, size_t n, F&& fn) {
+  std::vector<double> ns;
+  ns.reserve(n);
+  size_t found = 0;
+  for (size_t i = 0; i < n; i++) {
+    const auto t0 = Clock::now();
+    found += fn(macs[i]);
+    ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+  }
+  std::sort(ns.begin(), ns.end());
+  auto pct = [&](double p) { return ns[std::min(ns.size() - 1, static_cast<size_t>(p * ns.size()))]; };
+  std::printf("%-18s %-13s p50=%5.0f p99=%6.0f p99.9=%7.0f max=%8.0f ns  (hits %zu/%zu)\n", name,
+              pass, pct(0.50), pct(0.99), pct(0.999), ns.back(), found, n);
+}
+
+int main(int argc, char** argv) {
+  const std::string path = argc > 1 ? argv[1] : "data/manuf";
+  const size_t n = std::max<size_t>(kFirst, argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000);
+
+  oui::ManufDB loaded;
+  auto lr = loaded.load(path);
+  if (!lr.ok) {
+    std::fprintf(stderr, "load failed: %s\n", lr.message.c_str());
+    return 1;
+  }
+  const auto image = loaded.compiled();
+  std::printf("%u entries, image %zu KB\n", image->entry_count(), image->size() / 1024);
+
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> macs(n);
+  for (auto& mac : macs) {
+    const oui::ImageEntry& e = image->entries()[rng() % image->entry_count()];
+    const uint64_t host = e.maskBits >= 48 ? 0 : (rng() & ((uint64_t(1) << (48 - e.maskBits)) - 1));
+    mac = e.prefix | host;
+  }
+
+  const std::string file = "/tmp/oui_bench_lookup." + std::to_string(::getpid()) + ".img";
+  if (!image->save(file)) {
+    std::fprintf(stderr, "cannot write %s\n", file.c_str());
+    return 1;
+  }
+
+  struct Variant {
+    const char* name;
+    std::function<bool(oui::ManufDB&)> setup; // false: skip
+  };
+  auto placed = [&](oui::HugePages huge, bool lock) {
+    return [&, huge, lock](oui::ManufDB& db) {
+      oui::Placement p;
+      p.huge = huge;
+      p.lock = lock;
+      oui::PlacedImage pi = oui::place(*image, p);
+      for (const auto& w : pi.warnings) std::printf("  (%s)\n", w.c_str());
+      return pi.ok && db.relocate(pi.image);
+    };
+  };
+  const std::vector<Variant> variants = {
+    {"hash", [&](oui::ManufDB& db) { return db.load(path).ok; }},
+    {"mapped", [&](oui::ManufDB& db) { return db.attach(oui::CompiledDB::open_file(file)); }},
+    {"placed", placed(oui::HugePages::Off, false)},
+    {"placed+thp", placed(oui::HugePages::Transparent, false)},
+    {"placed+thp+mlock", placed(oui::HugePages::Transparent, true)},
+    {"placed+explicit", placed(oui::HugePages::Explicit, false)},
+  };
+
+  for (const auto& v : variants) {
+    oui::ManufDB db;
+    if (v.name != std::string("hash")) db = loaded;
+    if (!v.setup(db)) {
+      std::printf("%-18s skipped\n", v.name);
+      continue;
+    }
+    auto lookup = [&](uint64_t mac) { return db.lookup(mac).found; };
+    flush_caches();
+    run_pass(v.name, "lookup first", macs.data(), kFirst, lookup);
+    run_pass(v.name, "lookup steady", macs.data(), n, lookup);
+  }
+
+  // Table access alone, where page size and faults are not drowned out by
+  // the string copies. Fresh setup per row so "first" sees the faults.
+  for (const auto& v : variants) {
+    if (v.name == std::string("hash")) continue;
+    oui::ManufDB db = loaded;
+    if (!v.setup(db)) continue;
+    const auto img = db.compiled();
+    auto find = [&](uint64_t mac) { return img->find(mac) != nullptr; };
+    flush_caches();
+    run_pass(v.name, "find first", macs.data(), kFirst, find);
+    run_pass(v.name, "find steady", macs.data(), n, find);
+  }
+  ::unlink(file.c_str());
+  return 0;
+}
@@ -0,0 +1,53 @@
+// Per-request cost of the flight recorder (src/web/trace.h): everything a
+// connection backend adds for one request (start, five stamps, the request
+// line copy and the ring write), with recording on and off.
+//   oui_bench_trace 5000000
+#include "web/trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+static double per_request(web::FlightRecorder& rec, const std::string& req, long n) {
+  const auto t0 = Clock::now();
+  for (long i = 0; i < n; i++) {
+    web::RequestTrace t;
+    rec.start(t);
+    t.received(req);
+    t.stamp(web::RequestTrace::Parse);
+    t.stamp(web::RequestTrace::Lookup);
+    t.stamp(web::RequestTrace::Serialize);
+    t.status = 200;
+    t.sent(web::RequestTrace::Outcome::Sent, 196);
+    rec.record(t);
+  }
+  return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / static_cast<double>(n);
+}
+
+int main(int argc, char** argv) {
+  const long n = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 5000000;
+  const std::string req =
+    "GET /api/lookup?mac=00:1B:C5:12:34:56 HTTP/1.1\r\nHost: 127.0.0.1\r\nAccept: */*\r\n\r\n";
+
+  web::FlightRecorder off;
+  web::FlightRecorder on;
+  on.set_threshold_us(100000);
+  web::FlightRecorder allSlow;
+  allSlow.set_threshold_us(0);
+
+  per_request(on, req, n / 10); // warm up the shard and the rings
+  std::printf("recording off        %6.1f ns/request\n", per_request(off, req, n));
+  std::printf("recording on         %6.1f ns/request\n", per_request(on, req, n));
+  std::printf("on, every one slow   %6.1f ns/request\n", per_request(allSlow, req, n));
+  std::printf("trace_ticks()        %6.1f ns\n", [&] {
+    const auto t0 = Clock::now();
+    uint64_t sum = 0;
+    for (long i = 0; i < n; i++) sum += web::trace_ticks();
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+    return sum ? ns : 0.0;
+  }());
+  return 0;
+}
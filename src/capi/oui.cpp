@@ -0,0 +1,94 @@
+#include "capi/oui.h"
+#include "oui/compiled_db.h"
+#include "oui/mac.h"
+#include "oui/manuf_db.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+
+struct oui_db {
+  std::shared_ptr<const oui::CompiledDB> image;
+};
+
+static void set_error(char* err, size_t errlen, const std::string& msg) {
+  if (!err || errlen == 0) return;
+  size_t n = std::min(msg.size(), errlen - 1);
+  std::memcpy(err, msg.data(), n);
+  err[n] = '\0';
+}
+
+static int fill(const oui::CompiledDB* image, const oui::ImageEntry* e, oui_result* out) {
+  if (!out) return image && e;
+  if (!image || !e) {
+    *out = oui_result{0, 0, 0, "", ""};
+    return 0;
+  }
+  out->found = 1;
+  out->mask_bits = e->maskBits;
+  out->prefix = e->prefix;
+  // Pool strings are NUL-terminated (see ImageString).
+  out->vendor = image->vendor(e->vendorId).data();
+  out->comment = e->commentLen ? image->comment(*e).data() : "";
+  return 1;
+}
+
+extern "C" {
+
+oui_db* oui_open(const char* path, char* err, size_t errlen) {
+  try {
+    oui::ManufDB db;
+    auto r = db.load(path ? path : "");
+    if (!r.ok) {
+      set_error(err, errlen, r.message);
+      return nullptr;
+    }
+    return new oui_db{db.compiled()};
+  } catch (const std::exception& e) {
+    set_error(err, errlen, e.what());
+    return nullptr;
+  }
+}
+
+oui_db* oui_open_compiled(const char* path, char* err, size_t errlen) {
+  try {
+    auto image = oui::CompiledDB::open_file(path ? path : "");
+    if (!image) {
+      set_error(err, errlen, std::string("Cannot open compiled DB: ") + (path ? path : ""));
+      return nullptr;
+    }
+    return new oui_db{std::move(image)};
+  } catch (const std::exception& e) {
+    set_error(err, errlen, e.what());
+    return nullptr;
+  }
+}
+
+int oui_save_compiled(const oui_db* db, const char* path) {
+  if (!db || !path) return -1;
+  return db->image->save(path) ? 0 : -1;
+}
+
+int oui_lookup_u64(const oui_db* db, uint64_t mac48, oui_result* out) {
+  if (!db) return fill(nullptr, nullptr, out);
+  return fill(db->image.get(), db->image->find(mac48 & 0xFFFFFFFFFFFFULL), out);
+}
+
+int oui_lookup_str(const oui_db* db, const char* mac, oui_result* out) {
+  auto mp = mac ? oui::parse_mac_or_prefix(mac) : std::nullopt;
+  if (!db || !mp) return fill(nullptr, nullptr, out);
+  return fill(db->image.get(), db->image->find(mp->mac48), out);
+}
+
+size_t oui_lookup_batch(const oui_db* db, const uint64_t* macs, size_t n, oui_result* out) {
+  size_t found = 0;
+  for (size_t i = 0; i < n; i++) found += oui_lookup_u64(db, macs[i], out ? &out[i] : nullptr);
+  return found;
+}
+
+void oui_close(oui_db* db) {
+  delete db;
+}
+
+} // extern "C"
@@ -0,0 +1,54 @@
+/*
+ * C API for embedding the OUI lookup engine (liboui).
+ *
+ * A handle is immutable after open; lookups on one handle may run from any
+ * number of threads concurrently. Strings in results point into the handle
+ * and stay valid until oui_close().
+ */
+#ifndef OUI_H
+#define OUI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct oui_db oui_db;
+
+typedef struct oui_result {
+  int found;           /* 0 when no entry covers the MAC */
+  int mask_bits;       /* 0..48 */
+  uint64_t prefix;     /* matched prefix, 48-bit left-aligned */
+  const char* vendor;  /* NUL-terminated, "" when not found */
+  const char* comment; /* NUL-terminated, "" when absent */
+} oui_result;
+
+/* Parses a manuf file (plain or gzip). On failure returns NULL and, if err
+ * is non-NULL, writes a message of at most errlen bytes. */
+oui_db* oui_open(const char* path, char* err, size_t errlen);
+
+/* Maps an image written by oui_save_compiled() / `oui compile`. Much faster
+ * than oui_open() since nothing is parsed. */
+oui_db* oui_open_compiled(const char* path, char* err, size_t errlen);
+
+/* Writes the compiled image of db to path (atomic replace). 0 on success. */
+int oui_save_compiled(const oui_db* db, const char* path);
+
+/* Longest-prefix match of a 48-bit MAC (e.g. 0x001122334455). Returns found. */
+int oui_lookup_u64(const oui_db* db, uint64_t mac48, oui_result* out);
+
+/* Parses a textual MAC or prefix ("00:11:22", "001122334455", ...). */
+int oui_lookup_str(const oui_db* db, const char* mac, oui_result* out);
+
+/* Resolves n MACs into out[0..n). Returns the number found. */
+size_t oui_lookup_batch(const oui_db* db, const uint64_t* macs, size_t n, oui_result* out);
+
+void oui_close(oui_db* db);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OUI_H */
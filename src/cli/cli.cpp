@@ -1,15 +1,33 @@
 #include "cli/cli.h"
 
+#include "ipc/unix_server.h"
+#include "oui/compiled_db.h"
+#include "oui/db_handle.h"
+#include "oui/explain.h"
+#include "oui/format.h"
+#include "oui/mac.h"
 #include "oui/manuf_db.h"
+#include "oui/merge_cursor.h"
+#include "oui/placement.h"
+#include "oui/shm_cache.h"
+#include "oui/validate.h"
+#include "update/background.h"
 #include "update/updater.h"
 #include "web/http_server.h"
 #include "util/fs.h"
 #include "util/str.h"
 #include "util/json.h"
 
+#include <pthread.h>
+#include <signal.h>
+
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace {
@@ -20,14 +38,75 @@ R"(OUI Lookup Tool (manuf based)
 
 Usage:
   oui update [--db <path>] [--url <manuf_url>]
-  oui lookup [--db <path>] [--json] <mac-or-prefix>
-  oui serve  [--db <path>] [--host <ip>] [--port <n>]
+  oui lookup [--db <path>] [--json] [--no-shm] [--explain] <mac-or-prefix>
+  oui lookup [--format <fmt>] [--fields <list>] <mac-or-prefix>|-
+  oui lookup --all [--offset <n>] [--limit <n>] [--json] <prefix>[/bits]
+  oui compile [--db <path>] --out <image>
+  oui join   [--db <path>] [--sorted] [--column <n>] [--delim <c>] [--out <file>]
+             [--format tsv|csv|ndjson|binary] [--fields <list>] [<input>|-]
+  oui check  [--db <path>] [--json] [--limit <n>]
+  oui serve  [--db <path>] [--host <ip>] [--port <n>] [--listen <addr:port>]...
+             [--workers <n>] [--unix <socket>]
+             [--stats-file <path>] [--stats-interval <sec>]
+             [--io auto|uring|epoll|blocking] [--rate <req/s>] [--burst <n>]
+             [--max-conns <n>] [--max-request <bytes>] [--timeout-ms <ms>]
+             [--prefault] [--mlock] [--huge-pages off|thp|explicit] [--numa-replicate]
+             [--slow-us <us>] [--slow-file <path>] [--no-trace]
+             [--update-interval <sec>] [--update-jitter <sec>] [--url <manuf_url>]
 
 Examples:
   oui update
   oui lookup 00:11:22:33:44:55
   oui lookup --json 001122
   oui serve --port 8080
+  oui serve --port 8080 --unix /run/oui.sock
+  oui serve --listen 127.0.0.1:8080 --listen [::1]:8080
+  oui serve --listen [::]:8080 --workers 4
+  oui serve --workers 8 --huge-pages thp --mlock --numa-replicate --prefault
+  oui serve --update-interval 86400 --url file:///srv/mirror/manuf.gz
+
+lookup shares the compiled DB between processes through POSIX shared
+memory; the first run publishes it, later runs attach without parsing.
+Use --no-shm to always load the file directly. --explain lists every mask
+probed with timings and the duplicate lines dropped at load (implies --no-shm).
+--format is text (default), json, ndjson, csv, tsv or binary; --fields picks
+columns from input,found,prefix,mask_bits,vendor,comment (or all). `lookup -`
+reads one MAC per line from stdin and writes one record each (ndjson unless
+--format says otherwise; --json also means ndjson there).
+
+join appends prefix, mask_bits and vendor columns (--format tsv or csv) to
+every input line, taking the MAC from --column (1-based, default 1; --delim
+defaults to tab); --format ndjson/binary writes records only. With
+--sorted the input must be ascending by MAC: the DB is walked once in a
+merge join. Out-of-order input is reported and finished with normal lookups.
+
+--all lists every entry covering or covered by the prefix (e.g. the /28 and
+/36 blocks under 00:1B:C5), --limit per page starting at --offset.
+
+serve limits each source IP to --rate requests per second (token bucket of
+--burst, default 2x rate; off unless --rate is given) and answers 429 when
+exceeded. Counters are exported at GET /metrics.
+
+--listen may be repeated and replaces --host/--port; [::]:port (or :port)
+accepts IPv4 and IPv6 unless an IPv4 address is also listed on that port.
+--workers runs n event loops, each with its own SO_REUSEPORT sockets.
+
+serve keeps approximate per-MAC, per-prefix and per-vendor lookup counts in
+bounded memory (GET /api/stats/top?n=10); --stats-file writes the same JSON
+every --stats-interval seconds (default 60).
+
+serve records the stage timings of recent requests (accept, read, parse,
+lookup, serialize, write) in a per-thread ring, and keeps requests taking
+--slow-us or more (default 100000) in a separate one. GET /debug/slow?n=100
+shows both as JSON; kill -USR1 writes them all to --slow-file (default
+stderr). --no-trace turns recording off.
+
+--update-interval keeps serve's DB current: every interval (+- --update-jitter,
+default a tenth of it) a background thread fetches --url (file:// works
+offline), checks the result like `oui check`, writes it to --db and swaps it
+in. Requests in flight finish on the old version; on any failure the current
+DB stays. Version, age and update counters are exported at GET /metrics.
+Not available with --numa-replicate.
 )";
 }
 
@@ -36,9 +115,36 @@ struct Opts {
   std::string db = "data/manuf";
   std::string url = "https://www.wireshark.org/download/automated/data/manuf.gz";
   bool json = false;
+  bool shm = true;
+  bool explain = false;
+  bool all = false;
+  int offset = 0;
+  bool sorted = false;
+  std::string format;
+  unsigned fields = 0; // 0: the command's default
+  int column = 1;
+  char delim = '\t';
   std::string target;
+  std::string out;
+  int limit = 20;
   std::string host = "127.0.0.1";
   int port = 8080;
+  std::vector<web::ListenAddr> listen;
+  int workers = 1;
+  std::string statsFile;
+  int statsInterval = 60;
+  std::string unixSocket;
+  web::IoBackend io = web::IoBackend::Auto;
+  web::ServerLimits limits;
+  bool prefault = false;
+  bool mlock = false;
+  oui::HugePages hugePages = oui::HugePages::Off;
+  bool numaReplicate = false;
+  bool trace = true;
+  int slowUs = 100000;
+  std::string slowFile;
+  int updateInterval = 0; // seconds; 0: no background updates
+  int updateJitter = -1;  // -1: a tenth of the interval
 };
 
 bool take_arg(std::vector<std::string>& args, size_t& i, std::string& out) {
@@ -47,21 +153,92 @@ bool take_arg(std::vector<std::string>& args, size_t& i, std::string& out) {
   return true;
 }
 
-bool take_port(std::vector<std::string>& args, size_t& i, int& out) {
+char parse_delim(const std::string& value) {
+  if (value == "tab" || value == "\\t") return '\t';
+  if (value.size() == 1 && value[0] != '\n') return value[0];
+  throw std::runtime_error("Invalid value for --delim (one character or 'tab'): " + value);
+}
+
+oui::HugePages parse_huge_pages(const std::string& value) {
+  if (value == "off") return oui::HugePages::Off;
+  if (value == "thp") return oui::HugePages::Transparent;
+  if (value == "explicit") return oui::HugePages::Explicit;
+  throw std::runtime_error("Invalid value for --huge-pages: " + value);
+}
+
+web::IoBackend parse_io(const std::string& value) {
+  if (value == "auto") return web::IoBackend::Auto;
+  if (value == "uring") return web::IoBackend::Uring;
+  if (value == "epoll") return web::IoBackend::Epoll;
+  if (value == "blocking") return web::IoBackend::Blocking;
+  throw std::runtime_error("Invalid value for --io: " + value);
+}
+
+bool take_count(std::vector<std::string>& args, size_t& i, const char* name, int& out) {
   if (i + 1 >= args.size()) return false;
   const std::string& value = args[++i];
+  char* end = nullptr;
+  long n = std::strtol(value.c_str(), &end, 10);
+  if (end == value.c_str() || *end != '\0' || n < 0 || n > 1000000000) {
+    throw std::runtime_error(std::string("Invalid value for ") + name + ": " + value);
+  }
+  out = static_cast<int>(n);
+  return true;
+}
+
+bool take_rate(std::vector<std::string>& args, size_t& i, const char* name, double& out) {
+  if (i + 1 >= args.size()) return false;
+  const std::string& value = args[++i];
+  char* end = nullptr;
+  double v = std::strtod(value.c_str(), &end);
+  if (end == value.c_str() || *end != '\0' || !(v >= 0) || v > 1e9) {
+    throw std::runtime_error(std::string("Invalid value for ") + name + ": " + value);
+  }
+  out = v;
+  return true;
+}
+
+int parse_port(const std::string& value, const char* name) {
   char* end = nullptr;
   long port = std::strtol(value.c_str(), &end, 10);
   if (end == value.c_str() || *end != '\0') {
-    throw std::runtime_error("Invalid value for --port: " + value);
+    throw std::runtime_error(std::string("Invalid value for ") + name + ": " + value);
   }
   if (port < 1 || port > 65535) {
     throw std::runtime_error("Port out of range (1-65535): " + value);
   }
-  out = static_cast<int>(port);
+  return static_cast<int>(port);
+}
+
+bool take_port(std::vector<std::string>& args, size_t& i, int& out) {
+  if (i + 1 >= args.size()) return false;
+  out = parse_port(args[++i], "--port");
   return true;
 }
 
+// 1.2.3.4:80, [::1]:80, or :80 (all addresses, dual-stack).
+web::ListenAddr parse_listen(const std::string& value) {
+  web::ListenAddr la;
+  size_t colon;
+  if (!value.empty() && value[0] == '[') {
+    size_t close = value.find(']');
+    if (close == std::string::npos || close + 1 >= value.size() || value[close + 1] != ':') {
+      throw std::runtime_error("Invalid value for --listen: " + value);
+    }
+    la.host = value.substr(1, close - 1);
+    colon = close + 1;
+  } else {
+    colon = value.rfind(':');
+    if (colon == std::string::npos || value.find(':') != colon) {
+      throw std::runtime_error("Invalid value for --listen (use [ipv6]:port): " + value);
+    }
+    la.host = value.substr(0, colon);
+  }
+  if (la.host.empty()) la.host = "::";
+  la.port = parse_port(value.substr(colon + 1), "--listen");
+  return la;
+}
+
 Opts parse(int argc, char** argv) {
   Opts o;
   if (argc < 2) {
@@ -78,19 +255,106 @@ Opts parse(int argc, char** argv) {
       if (!take_arg(args, i, o.db)) throw std::runtime_error("Missing value for --db");
     } else if (a == "--url") {
       if (!take_arg(args, i, o.url)) throw std::runtime_error("Missing value for --url");
+    } else if (a == "--out") {
+      if (!take_arg(args, i, o.out)) throw std::runtime_error("Missing value for --out");
+    } else if (a == "--limit") {
+      if (!take_count(args, i, "--limit", o.limit)) throw std::runtime_error("Missing value for --limit");
     } else if (a == "--json") {
       o.json = true;
+    } else if (a == "--explain") {
+      o.explain = true;
+    } else if (a == "--format") {
+      if (!take_arg(args, i, o.format)) throw std::runtime_error("Missing value for --format");
+      oui::fmt::Format f;
+      if (!oui::fmt::parse_format(o.format, f)) throw std::runtime_error("Invalid value for --format: " + o.format);
+    } else if (a == "--fields") {
+      std::string v;
+      if (!take_arg(args, i, v)) throw std::runtime_error("Missing value for --fields");
+      if (!oui::fmt::parse_fields(v, o.fields)) throw std::runtime_error("Invalid value for --fields: " + v);
+    } else if (a == "--sorted") {
+      o.sorted = true;
+    } else if (a == "--column") {
+      if (!take_count(args, i, "--column", o.column)) throw std::runtime_error("Missing value for --column");
+      if (o.column < 1) throw std::runtime_error("--column is 1-based");
+    } else if (a == "--delim") {
+      std::string v;
+      if (!take_arg(args, i, v)) throw std::runtime_error("Missing value for --delim");
+      o.delim = parse_delim(v);
+    } else if (a == "--all") {
+      o.all = true;
+    } else if (a == "--offset") {
+      if (!take_count(args, i, "--offset", o.offset)) throw std::runtime_error("Missing value for --offset");
+    } else if (a == "--no-shm") {
+      o.shm = false;
     } else if (a == "--host") {
       if (!take_arg(args, i, o.host)) throw std::runtime_error("Missing value for --host");
     } else if (a == "--port") {
       if (!take_port(args, i, o.port)) throw std::runtime_error("Missing value for --port");
-    } else if (!a.empty() && a[0] == '-') {
+    } else if (a == "--listen") {
+      std::string v;
+      if (!take_arg(args, i, v)) throw std::runtime_error("Missing value for --listen");
+      o.listen.push_back(parse_listen(v));
+    } else if (a == "--workers") {
+      if (!take_count(args, i, "--workers", o.workers)) throw std::runtime_error("Missing value for --workers");
+      if (o.workers < 1 || o.workers > 1024) throw std::runtime_error("--workers must be 1-1024");
+    } else if (a == "--stats-file") {
+      if (!take_arg(args, i, o.statsFile)) throw std::runtime_error("Missing value for --stats-file");
+    } else if (a == "--stats-interval") {
+      if (!take_count(args, i, "--stats-interval", o.statsInterval)) throw std::runtime_error("Missing value for --stats-interval");
+      if (o.statsInterval < 1) throw std::runtime_error("--stats-interval must be at least 1");
+    } else if (a == "--unix") {
+      if (!take_arg(args, i, o.unixSocket)) throw std::runtime_error("Missing value for --unix");
+    } else if (a == "--io") {
+      std::string v;
+      if (!take_arg(args, i, v)) throw std::runtime_error("Missing value for --io");
+      o.io = parse_io(v);
+    } else if (a == "--rate") {
+      if (!take_rate(args, i, "--rate", o.limits.ratePerSec)) throw std::runtime_error("Missing value for --rate");
+    } else if (a == "--burst") {
+      if (!take_rate(args, i, "--burst", o.limits.burst)) throw std::runtime_error("Missing value for --burst");
+    } else if (a == "--max-conns") {
+      int n = 0;
+      if (!take_count(args, i, "--max-conns", n)) throw std::runtime_error("Missing value for --max-conns");
+      if (n < 1) throw std::runtime_error("--max-conns must be at least 1");
+      o.limits.maxConnections = static_cast<size_t>(n);
+    } else if (a == "--max-request") {
+      int n = 0;
+      if (!take_count(args, i, "--max-request", n)) throw std::runtime_error("Missing value for --max-request");
+      if (n < 256) throw std::runtime_error("--max-request must be at least 256");
+      o.limits.maxRequestBytes = static_cast<size_t>(n);
+    } else if (a == "--timeout-ms") {
+      if (!take_count(args, i, "--timeout-ms", o.limits.ioTimeoutMs)) throw std::runtime_error("Missing value for --timeout-ms");
+    } else if (a == "--prefault") {
+      o.prefault = true;
+    } else if (a == "--mlock") {
+      o.mlock = true;
+    } else if (a == "--huge-pages") {
+      std::string v;
+      if (!take_arg(args, i, v)) throw std::runtime_error("Missing value for --huge-pages");
+      o.hugePages = parse_huge_pages(v);
+    } else if (a == "--numa-replicate") {
+      o.numaReplicate = true;
+    } else if (a == "--slow-us") {
+      if (!take_count(args, i, "--slow-us", o.slowUs)) throw std::runtime_error("Missing value for --slow-us");
+    } else if (a == "--slow-file") {
+      if (!take_arg(args, i, o.slowFile)) throw std::runtime_error("Missing value for --slow-file");
+    } else if (a == "--no-trace") {
+      o.trace = false;
+    } else if (a == "--update-interval") {
+      if (!take_count(args, i, "--update-interval", o.updateInterval)) throw std::runtime_error("Missing value for --update-interval");
+    } else if (a == "--update-jitter") {
+      if (!take_count(args, i, "--update-jitter", o.updateJitter)) throw std::runtime_error("Missing value for --update-jitter");
+    } else if (a.size() > 1 && a[0] == '-') {
       throw std::runtime_error("Unknown option: " + a);
     } else {
       // positional
       o.target = a;
     }
   }
+  // Replicas are copied once at startup; a swap would leave them behind.
+  if (o.updateInterval > 0 && o.numaReplicate) {
+    throw std::runtime_error("--update-interval cannot be combined with --numa-replicate");
+  }
   return o;
 }
 
@@ -104,6 +368,96 @@ int cmd_update(const Opts& o) {
   }
   std::cout << "Updated DB: " << o.db << "\n";
   std::cout << "Bytes: " << r.bytes << "\n";
+  std::cout << "Result: " << r.message << "\n";
+  return 0;
+}
+
+// Attach to a published image when possible; otherwise load and publish one.
+bool load_shared(const Opts& o, oui::ManufDB& db) {
+  std::string resolved = o.shm ? oui::resolve_db_path(o.db) : "";
+  auto stamp = resolved.empty() ? std::nullopt : oui::shm::stamp_of(resolved);
+  if (stamp && db.attach(oui::shm::attach(resolved, *stamp))) return true;
+
+  auto lr = db.load(o.db);
+  if (!lr.ok) {
+    std::cerr << "DB load failed: " << lr.message << "\n";
+    return false;
+  }
+  if (stamp) oui::shm::publish(resolved, *stamp, *db.compiled());
+  return true;
+}
+
+oui::fmt::Writer output_writer(const Opts& o, oui::fmt::Format fallback, unsigned defaultFields) {
+  oui::fmt::Format f = fallback;
+  if (o.json) f = oui::fmt::Format::Json;
+  if (!o.format.empty()) oui::fmt::parse_format(o.format, f);
+  return oui::fmt::writer(f, o.fields ? o.fields : defaultFields);
+}
+
+// Buffered output in ~1 MB writes; callers append to buf and call flush().
+struct Output {
+  static const size_t kBlock = 1 << 20;
+  std::FILE* file;
+  std::string buf;
+  bool ok = true;
+
+  explicit Output(std::FILE* f) : file(f) { buf.reserve(2 * kBlock); }
+  void flush(bool force = false) {
+    if (!force && buf.size() < kBlock) return;
+    ok = ok && std::fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+    buf.clear();
+  }
+};
+
+// Calls fn(line) for every line of in (without '\n' or a trailing '\r').
+// Lines are split in place; only a line crossing a block boundary is copied.
+template <typename F>
+bool for_each_line(std::FILE* in, F&& fn) {
+  std::vector<char> buf(1 << 20);
+  std::string carry;
+  auto emit = [&](std::string_view line) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    fn(line);
+  };
+  size_t n;
+  while ((n = std::fread(buf.data(), 1, buf.size(), in)) > 0) {
+    std::string_view block(buf.data(), n);
+    size_t start = 0;
+    for (size_t nl; (nl = block.find('\n', start)) != std::string_view::npos; start = nl + 1) {
+      if (!carry.empty()) {
+        carry.append(block.data() + start, nl - start);
+        emit(carry);
+        carry.clear();
+      } else {
+        emit(block.substr(start, nl - start));
+      }
+    }
+    carry.append(block.data() + start, n - start);
+  }
+  if (!carry.empty()) emit(carry);
+  return !std::ferror(in);
+}
+
+int lookup_stdin(const Opts& o, const oui::CompiledDB& image) {
+  // One record per input line: json becomes ndjson, as in join, since
+  // back-to-back objects are not a JSON document.
+  oui::fmt::Format format = oui::fmt::Format::Ndjson;
+  if (!o.format.empty()) oui::fmt::parse_format(o.format, format);
+  if (format == oui::fmt::Format::Json) format = oui::fmt::Format::Ndjson;
+  const oui::fmt::Writer write = oui::fmt::writer(format, o.fields ? o.fields : oui::fmt::kBulkFields);
+  Output out(stdout);
+  write.header(out.buf);
+  const bool readOk = for_each_line(stdin, [&](std::string_view line) {
+    if (line.empty()) return;
+    auto mp = oui::parse_mac_or_prefix(line);
+    write(oui::fmt::from_image(image, mp ? image.find(mp->mac48) : nullptr, line), out.buf);
+    out.flush();
+  });
+  out.flush(true);
+  if (!readOk || !out.ok || std::fflush(stdout) != 0) {
+    std::cerr << "lookup: " << (readOk ? "write" : "read") << " failed\n";
+    return 1;
+  }
   return 0;
 }
 
@@ -113,50 +467,376 @@ int cmd_lookup(const Opts& o) {
     return 2;
   }
   oui::ManufDB db;
+  if (o.explain) {
+    // load-time overwrite records only exist after a full parse
+    auto lr = db.load(o.db);
+    if (!lr.ok) {
+      std::cerr << "DB load failed: " << lr.message << "\n";
+      return 1;
+    }
+    auto ex = db.explain(o.target);
+    if (o.json) {
+      std::cout << util::json::stringify(oui::explain_to_json(ex)) << "\n";
+    } else {
+      std::cout << oui::explain_to_text(ex);
+    }
+    return 0;
+  }
+  if (!load_shared(o, db)) return 1;
+
+  if (o.all) {
+    auto rr = db.lookup_all(o.target, static_cast<size_t>(o.offset), static_cast<size_t>(o.limit));
+    if (o.json) {
+      std::cout << util::json::stringify(oui::range_to_json(rr)) << "\n";
+    } else {
+      std::cout << oui::range_to_text(rr);
+    }
+    return rr.parsed ? 0 : 2;
+  }
+
+  if (o.target == "-") return lookup_stdin(o, *db.compiled());
+
+  const oui::fmt::Writer write = output_writer(o, oui::fmt::Format::Text, oui::fmt::kDefaultFields);
+  std::string out;
+  write.header(out);
+  write(oui::fmt::from_result(db.lookup(o.target), o.target), out);
+  if (write.format == oui::fmt::Format::Json) out.push_back('\n');
+  std::cout << out;
+  return 0;
+}
+
+// Field `column` (0-based) of line; empty when the line has fewer fields.
+std::string_view field_of(std::string_view line, size_t column, char delim) {
+  size_t start = 0;
+  for (size_t c = 0; c < column; c++) {
+    start = line.find(delim, start);
+    if (start == std::string_view::npos) return {};
+    start++;
+  }
+  const size_t end = line.find(delim, start);
+  return line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+}
+
+int cmd_join(const Opts& o) {
+  // csv/tsv extend the input line; the others emit standalone records, which
+  // need the input to be useful.
+  oui::fmt::Format format = o.delim == ',' ? oui::fmt::Format::Csv : oui::fmt::Format::Tsv;
+  if (o.json) format = oui::fmt::Format::Ndjson;
+  if (!o.format.empty()) oui::fmt::parse_format(o.format, format);
+  if (format == oui::fmt::Format::Text) {
+    std::cerr << "join: --format text is not supported; use tsv, csv, ndjson or binary\n";
+    return 2;
+  }
+  if (format == oui::fmt::Format::Json) format = oui::fmt::Format::Ndjson;
+  const bool append = format == oui::fmt::Format::Csv || format == oui::fmt::Format::Tsv;
+  const oui::fmt::Writer write = oui::fmt::writer(
+    format, o.fields ? o.fields : append ? oui::fmt::kJoinFields : oui::fmt::kBulkFields);
+
+  oui::ManufDB db;
+  if (!load_shared(o, db)) return 1;
+  const oui::CompiledDB& image = *db.compiled();
+
+  const bool fromStdin = o.target.empty() || o.target == "-";
+  std::FILE* in = fromStdin ? stdin : std::fopen(o.target.c_str(), "rb");
+  if (!in) {
+    std::cerr << "join: cannot open " << o.target << "\n";
+    return 1;
+  }
+  std::FILE* file = o.out.empty() ? stdout : std::fopen(o.out.c_str(), "wb");
+  if (!file) {
+    std::cerr << "join: cannot create " << o.out << "\n";
+    if (!fromStdin) std::fclose(in);
+    return 1;
+  }
+
+  oui::MergeCursor cursor(image);
+  const size_t column = static_cast<size_t>(o.column - 1);
+  Output out(file);
+  uint64_t lineNo = 0;
+
+  const bool readOk = for_each_line(in, [&](std::string_view line) {
+    lineNo++;
+    // Only full MACs count; a header like "mac" would otherwise parse as hex.
+    const std::string_view field = field_of(line, column, o.delim);
+    const oui::ImageEntry* hit = nullptr;
+    auto mp = oui::parse_mac_or_prefix(field);
+    if (mp && mp->bitsHint == 48) {
+      const bool wasSorted = cursor.sorted();
+      hit = o.sorted ? cursor.find(mp->mac48) : image.find(mp->mac48);
+      if (wasSorted && !cursor.sorted()) {
+        std::cerr << "join: input not sorted at line " << lineNo
+                  << "; continuing with per-record lookups\n";
+      }
+    }
+    if (append) {
+      out.buf.append(line.data(), line.size());
+      out.buf.push_back(o.delim);
+    }
+    write(oui::fmt::from_image(image, hit, field), out.buf);
+    out.flush();
+  });
+
+  out.flush(true);
+  if (!fromStdin) std::fclose(in);
+  const bool writeOk = (file == stdout ? std::fflush(file) == 0 : std::fclose(file) == 0) && out.ok;
+  if (!readOk || !writeOk) {
+    std::cerr << "join: " << (readOk ? "write" : "read") << " failed\n";
+    return 1;
+  }
+  return 0;
+}
+
+int cmd_compile(const Opts& o) {
+  if (o.out.empty()) {
+    std::cerr << "compile: missing --out <image>\n";
+    return 2;
+  }
+  oui::ManufDB db;
   auto lr = db.load(o.db);
   if (!lr.ok) {
     std::cerr << "DB load failed: " << lr.message << "\n";
     return 1;
   }
+  util::fs::ensure_parent_dir(o.out);
+  if (!db.compiled()->save(o.out)) {
+    std::cerr << "Cannot write " << o.out << "\n";
+    return 1;
+  }
+  std::cout << "Compiled " << db.compiled()->entry_count() << " entries to " << o.out << "\n";
+  return 0;
+}
 
-  auto res = db.lookup(o.target);
-  if (!res.found) {
-    if (o.json) {
-      std::cout << "{\"found\":false}\n";
-    } else {
-      std::cout << "No match\n";
-    }
-    return 0;
+std::string show_prefix(uint64_t prefix, int bits) {
+  return oui::prefix_to_string(prefix, bits) + "/" + std::to_string(bits);
+}
+
+int cmd_check(const Opts& o) {
+  oui::ManufDB db;
+  auto lr = db.load(o.db);
+  if (!lr.ok) {
+    std::cerr << "DB load failed: " << lr.message << "\n";
+    return 1;
   }
+  auto r = oui::check(db);
+  std::string why;
+  const bool fatal = r.fatal(why);
+  const size_t limit = static_cast<size_t>(o.limit);
 
   if (o.json) {
-    util::json::Object obj;
-    obj["found"] = util::json::Value(true);
-    obj["vendor"] = util::json::Value(res.entry.vendor);
-    obj["prefix"] = util::json::Value(res.best_prefix);
-    obj["mask_bits"] = util::json::Value(res.entry.maskBits);
-    obj["comment"] = util::json::Value(res.entry.comment);
+    using util::json::Array;
+    using util::json::Object;
+    using util::json::Value;
+    auto lines = [&](const std::vector<oui::LineIssue>& v) {
+      Array a;
+      for (size_t i = 0; i < v.size() && i < limit; i++) {
+        a.push_back(Value(Object{{"line", Value(static_cast<int>(v[i].line))}, {"text", Value(v[i].text)}}));
+      }
+      return Value(a);
+    };
+    auto overwrites = [&](const std::vector<oui::Overwrite>& v) {
+      Array a;
+      for (size_t i = 0; i < v.size() && i < limit; i++) {
+        a.push_back(Value(Object{{"prefix", Value(show_prefix(v[i].prefix, v[i].maskBits))},
+                                 {"line", Value(static_cast<int>(v[i].line))},
+                                 {"vendor", Value(v[i].vendor)},
+                                 {"dropped_line", Value(static_cast<int>(v[i].previousLine))},
+                                 {"dropped_vendor", Value(v[i].previousVendor)}}));
+      }
+      return Value(a);
+    };
+    Array nested;
+    for (size_t i = 0; i < r.nested.size() && i < limit; i++) {
+      const auto& n = r.nested[i];
+      nested.push_back(Value(Object{{"prefix", Value(show_prefix(n.prefix, n.maskBits))},
+                                    {"vendor", Value(n.vendor)},
+                                    {"outer", Value(show_prefix(n.outerPrefix, n.outerMaskBits))},
+                                    {"outer_vendor", Value(n.outerVendor)}}));
+    }
+    Object masks;
+    for (const auto& kv : r.masks) {
+      masks[std::to_string(kv.first)] = Value(Object{{"entries", Value(static_cast<int>(kv.second.entries))},
+                                                     {"vendors", Value(static_cast<int>(kv.second.vendors))},
+                                                     {"nested", Value(static_cast<int>(kv.second.nested))}});
+    }
+    Object counts{{"malformed", Value(static_cast<int>(r.malformed.size()))},
+                  {"host_bits", Value(static_cast<int>(r.hostBits.size()))},
+                  {"duplicates", Value(static_cast<int>(r.duplicates.size()))},
+                  {"conflicts", Value(static_cast<int>(r.conflicts.size()))},
+                  {"nested", Value(static_cast<int>(r.nested.size()))}};
+    Object obj{{"ok", Value(!fatal)},
+               {"entries", Value(static_cast<int>(r.entries))},
+               {"counts", Value(counts)},
+               {"masks", Value(masks)},
+               {"malformed", lines(r.malformed)},
+               {"host_bits", lines(r.hostBits)},
+               {"duplicates", overwrites(r.duplicates)},
+               {"conflicts", overwrites(r.conflicts)},
+               {"nested", Value(nested)},
+               {"check_us", Value(static_cast<int>(r.nanos / 1000))}};
+    if (fatal) obj["error"] = Value(why);
     std::cout << util::json::stringify(obj) << "\n";
-  } else {
-    std::cout << "Vendor: " << res.entry.vendor << "\n";
-    std::cout << "Prefix: " << res.best_prefix << "/" << res.entry.maskBits << "\n";
-    if (!res.entry.comment.empty()) std::cout << "Comment: " << res.entry.comment << "\n";
+    return fatal ? 1 : 0;
+  }
+
+  std::cout << "Entries: " << r.entries << " (check " << r.nanos / 1000 << " us)\n";
+  for (const auto& kv : r.masks) {
+    std::cout << "  /" << kv.first << ": " << kv.second.entries << " entries, "
+              << kv.second.vendors << " vendors, " << kv.second.nested << " nested\n";
+  }
+  auto section = [&](const char* title, size_t total, auto&& print_item) {
+    std::cout << title << ": " << total << "\n";
+    for (size_t i = 0; i < total && i < limit; i++) print_item(i);
+    if (total > limit) std::cout << "  ... " << (total - limit) << " more\n";
+  };
+  section("Malformed lines", r.malformed.size(), [&](size_t i) {
+    std::cout << "  line " << r.malformed[i].line << ": " << r.malformed[i].text << "\n";
+  });
+  section("Host bits beyond mask", r.hostBits.size(), [&](size_t i) {
+    std::cout << "  line " << r.hostBits[i].line << ": " << r.hostBits[i].text << "\n";
+  });
+  section("Exact duplicates", r.duplicates.size(), [&](size_t i) {
+    const auto& d = r.duplicates[i];
+    std::cout << "  " << show_prefix(d.prefix, d.maskBits) << " lines " << d.previousLine
+              << " and " << d.line << "\n";
+  });
+  section("Conflicting vendors", r.conflicts.size(), [&](size_t i) {
+    const auto& c = r.conflicts[i];
+    std::cout << "  " << show_prefix(c.prefix, c.maskBits) << " line " << c.previousLine << " ("
+              << c.previousVendor << ") overwritten by line " << c.line << " (" << c.vendor << ")\n";
+  });
+  section("Nested prefixes", r.nested.size(), [&](size_t i) {
+    const auto& n = r.nested[i];
+    std::cout << "  " << show_prefix(n.prefix, n.maskBits) << " (" << n.vendor << ") inside "
+              << show_prefix(n.outerPrefix, n.outerMaskBits) << " (" << n.outerVendor << ")\n";
+  });
+  if (fatal) {
+    std::cout << "FAILED: " << why << "\n";
+    return 1;
   }
+  std::cout << "OK\n";
   return 0;
 }
 
+// Moves lookups onto copies of the compiled image placed as --huge-pages and
+// --mlock ask, one per NUMA node with --numa-replicate. The first copy
+// replaces db's own tables; the others are kept in copies.
+bool place_db(const Opts& o, oui::ManufDB& db, std::vector<std::unique_ptr<oui::ManufDB>>& copies,
+              std::vector<web::DbReplica>& replicas) {
+  std::vector<oui::NumaNode> nodes;
+  if (o.numaReplicate) nodes = oui::numa_nodes();
+  else nodes.push_back({-1, {}});
+
+  for (size_t i = 0; i < nodes.size(); i++) {
+    oui::Placement p;
+    p.huge = o.hugePages;
+    p.lock = o.mlock;
+    p.node = nodes[i].id;
+    oui::PlacedImage placed = oui::place(*db.compiled(), p);
+    for (const auto& w : placed.warnings) std::cerr << "warning: " << w << "\n";
+    if (!placed.ok) {
+      std::cerr << "DB placement failed: " << placed.message << "\n";
+      return false;
+    }
+    oui::ManufDB* target = &db;
+    if (i > 0) {
+      copies.push_back(std::make_unique<oui::ManufDB>(db));
+      target = copies.back().get();
+    }
+    if (!target->relocate(placed.image)) {
+      std::cerr << "DB placement failed: copy does not match\n";
+      return false;
+    }
+    if (o.numaReplicate) replicas.push_back({target, nodes[i].cpus});
+  }
+  if (o.numaReplicate) {
+    std::cout << "NUMA: " << nodes.size() << " node(s), one DB copy each\n";
+    if (static_cast<size_t>(o.workers) < nodes.size()) {
+      std::cerr << "warning: --workers " << o.workers << " leaves " << nodes.size() - o.workers
+                << " NUMA node(s) without a worker\n";
+    }
+  }
+  return true;
+}
+
 int cmd_serve(const Opts& o) {
-  oui::ManufDB db;
-  auto lr = db.load(o.db);
+  auto db = std::make_unique<oui::ManufDB>();
+  auto lr = db->load(o.db);
   if (!lr.ok) {
     std::cerr << "DB load failed: " << lr.message << "\n";
     std::cerr << "Tip: run `oui update` first.\n";
     return 1;
   }
+  const std::string dbFile = oui::resolve_db_path(o.db);
+
+  std::vector<std::unique_ptr<oui::ManufDB>> copies;
+  std::vector<web::DbReplica> replicas;
+  const bool placed = o.mlock || o.hugePages != oui::HugePages::Off || o.numaReplicate;
+  if (placed && !place_db(o, *db, copies, replicas)) return 1;
+  // Both servers read through the handle, so the updater can swap versions
+  // under them.
+  oui::DbHandle handle(std::move(db));
+
+  // SIGUSR1 dumps the slow-request recorder. Block it before any thread
+  // starts; the server's dump thread is the only one waiting for it.
+  sigset_t usr1;
+  sigemptyset(&usr1);
+  sigaddset(&usr1, SIGUSR1);
+  pthread_sigmask(SIG_BLOCK, &usr1, nullptr);
+
+  std::unique_ptr<ipc::UnixServer> unixServer;
+  if (!o.unixSocket.empty()) {
+    unixServer = std::make_unique<ipc::UnixServer>(o.unixSocket, &handle);
+    std::string err;
+    if (!unixServer->start(err)) {
+      std::cerr << "Unix listener failed: " << err << "\n";
+      return 1;
+    }
+    std::cout << "Binary API on unix:" << o.unixSocket << "\n";
+  }
 
-  web::HttpServer server(o.host, o.port, o.db, &db);
-  std::cout << "Serving on http://" << o.host << ":" << o.port << "\n";
+  web::HttpServer server(o.host, o.port, o.db, &handle);
+  server.set_backend(o.io);
+  server.set_limits(o.limits);
+  server.set_workers(static_cast<unsigned>(o.workers));
+  server.set_replicas(std::move(replicas));
+  server.set_prewarm(o.prefault);
+  server.set_trace(o.trace ? o.slowUs : -1, o.slowFile);
+  if (!o.listen.empty()) server.set_listen(o.listen);
+  if (!o.statsFile.empty()) {
+    util::fs::ensure_parent_dir(o.statsFile);
+    server.set_stats_snapshot(o.statsFile, o.statsInterval);
+  }
+  for (const auto& la : o.listen.empty() ? std::vector<web::ListenAddr>{{o.host, o.port}} : o.listen) {
+    const bool v6 = la.host.find(':') != std::string::npos;
+    std::cout << "Serving on http://" << (v6 ? "[" + la.host + "]" : la.host) << ":" << la.port << "\n";
+  }
   std::cout << "DB: " << o.db << "\n";
+
+  std::unique_ptr<update::BackgroundUpdater> updater;
+  if (o.updateInterval > 0) {
+    update::BackgroundOptions uo;
+    uo.url = o.url;
+    uo.dbPath = dbFile;
+    uo.intervalSec = o.updateInterval;
+    uo.jitterSec = o.updateJitter >= 0 ? o.updateJitter : o.updateInterval / 10;
+    updater = std::make_unique<update::BackgroundUpdater>(handle, uo);
+    if (placed) {
+      // New versions get the same huge pages / mlock as the first one.
+      updater->set_prepare([&o](oui::ManufDB& next, std::string& err) {
+        std::vector<std::unique_ptr<oui::ManufDB>> noCopies;
+        std::vector<web::DbReplica> noReplicas;
+        if (place_db(o, next, noCopies, noReplicas)) return true;
+        err = "DB placement failed";
+        return false;
+      });
+    }
+    updater->set_on_publish([&server](uint64_t version, const std::string& tag) {
+      server.set_db_tag(version, tag);
+    });
+    server.set_updater(updater.get());
+    updater->start();
+    std::cout << "Updates: every " << uo.intervalSec << "s (+-" << uo.jitterSec << "s) from " << o.url << "\n";
+  }
   return server.serve_forever();
 }
 
@@ -174,6 +854,9 @@ int run(int argc, char** argv) {
 
   if (o.cmd == "update") return cmd_update(o);
   if (o.cmd == "lookup") return cmd_lookup(o);
+  if (o.cmd == "compile") return cmd_compile(o);
+  if (o.cmd == "join")    return cmd_join(o);
+  if (o.cmd == "check")  return cmd_check(o);
   if (o.cmd == "serve")  return cmd_serve(o);
 
   std::cerr << "Unknown command: " << o.cmd << "\n";
@@ -0,0 +1,155 @@
+#include "ipc/client.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace ipc {
+
+Client::Client(std::string socketPath) : path_(std::move(socketPath)) {}
+
+Client::~Client() {
+  close();
+}
+
+bool Client::fail(const std::string& msg) {
+  error_ = msg;
+  close();
+  return false;
+}
+
+bool Client::connect() {
+  close();
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path_.empty() || path_.size() >= sizeof(addr.sun_path)) {
+    error_ = "invalid unix socket path: " + path_;
+    return false;
+  }
+  std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+
+  fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd_ < 0) return fail("socket(AF_UNIX) failed");
+  if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    return fail("connect() failed: " + path_);
+  }
+  return true;
+}
+
+void Client::close() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+}
+
+// buf_ holds header space followed by the request payload.
+bool Client::exchange(uint16_t op, uint32_t count, FrameHeader& resp) {
+  if (fd_ < 0 && !connect()) return false;
+
+  FrameHeader req;
+  req.op = op;
+  req.count = count;
+  encode_header(buf_.data(), req);
+  if (!write_full(fd_, buf_.data(), buf_.size())) return fail("write failed");
+
+  uint8_t hdr[kHeaderSize];
+  if (!read_full(fd_, hdr, sizeof(hdr))) return fail("read failed");
+  resp = decode_header(hdr);
+  if (resp.magic != kMagic || resp.op != op) return fail("protocol error");
+  if (resp.status != STATUS_OK) {
+    error_ = "server status " + std::to_string(resp.status);
+    return false;
+  }
+
+  uint8_t gen[4];
+  if (!read_full(fd_, gen, sizeof(gen))) return fail("read failed");
+  uint32_t g = get_u32(gen);
+  if (g != generation_) {
+    vendors_.clear();
+    generation_ = g;
+  }
+  return true;
+}
+
+bool Client::lookup(const uint64_t* macs, size_t n, Record* out) {
+  while (n > 0) {
+    uint32_t count = static_cast<uint32_t>(std::min<size_t>(n, kMaxCount));
+    buf_.resize(kHeaderSize + size_t(count) * kMacSize);
+    for (uint32_t i = 0; i < count; i++) {
+      encode_mac(buf_.data() + kHeaderSize + i * kMacSize, macs[i]);
+    }
+
+    FrameHeader resp;
+    if (!exchange(OP_LOOKUP, count, resp)) return false;
+    if (resp.count != count) return fail("protocol error");
+
+    buf_.resize(size_t(count) * kRecordSize);
+    if (!read_full(fd_, buf_.data(), buf_.size())) return fail("read failed");
+    for (uint32_t i = 0; i < count; i++) out[i] = decode_record(buf_.data() + i * kRecordSize);
+
+    macs += count;
+    out += count;
+    n -= count;
+  }
+  return true;
+}
+
+bool Client::fetch_vendors(const std::vector<uint32_t>& ids) {
+  if (ids.empty()) return true;
+  buf_.resize(kHeaderSize + ids.size() * 4);
+  for (size_t i = 0; i < ids.size(); i++) put_u32(buf_.data() + kHeaderSize + i * 4, ids[i]);
+
+  FrameHeader resp;
+  if (!exchange(OP_VENDORS, static_cast<uint32_t>(ids.size()), resp)) return false;
+  if (resp.count != ids.size()) return fail("protocol error");
+
+  for (uint32_t id : ids) {
+    uint8_t len[4];
+    if (!read_full(fd_, len, sizeof(len))) return fail("read failed");
+    std::string name(get_u32(len), '\0');
+    if (!name.empty() && !read_full(fd_, name.data(), name.size())) return fail("read failed");
+    vendors_[id] = std::move(name);
+  }
+  return true;
+}
+
+bool Client::resolve(const uint64_t* macs, size_t n, Resolved* out) {
+  records_.resize(n);
+  // A DB reload between the two requests invalidates the ids; retry once.
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (!lookup(macs, n, records_.data())) return false;
+    const uint32_t gen = generation_;
+
+    std::vector<uint32_t> missing;
+    for (const Record& r : records_) {
+      if (r.vendorId != kNoVendor && !vendors_.count(r.vendorId)) missing.push_back(r.vendorId);
+    }
+    std::sort(missing.begin(), missing.end());
+    missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+    if (!fetch_vendors(missing)) return false;
+    if (gen != generation_) {
+      vendors_.clear();
+      continue;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      out[i] = Resolved{};
+      if (records_[i].vendorId == kNoVendor) continue;
+      out[i].found = true;
+      out[i].maskBits = records_[i].maskBits;
+      out[i].vendor = vendor(records_[i].vendorId);
+    }
+    return true;
+  }
+  error_ = "DB changed during resolve";
+  return false;
+}
+
+const std::string* Client::vendor(uint32_t vendorId) const {
+  auto it = vendors_.find(vendorId);
+  return it == vendors_.end() ? nullptr : &it->second;
+}
+
+} // namespace ipc
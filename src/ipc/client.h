@@ -0,0 +1,54 @@
+#pragma once
+#include "ipc/protocol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ipc {
+
+struct Resolved {
+  bool found = false;
+  int maskBits = 0;
+  const std::string* vendor = nullptr; // owned by the Client's vendor cache
+};
+
+// Blocking client for `oui serve --unix`. Not thread-safe; use one per thread.
+// Vendor names are fetched lazily and cached until the server's DB generation
+// changes.
+class Client {
+public:
+  explicit Client(std::string socketPath);
+  ~Client();
+
+  Client(const Client&) = delete;
+  Client& operator=(const Client&) = delete;
+
+  bool connect();
+  void close();
+  const std::string& last_error() const { return error_; }
+
+  // Raw records for n 48-bit MACs; splits into frames of kMaxCount.
+  bool lookup(const uint64_t* macs, size_t n, Record* out);
+  // Records plus vendor names (fetched for ids not cached yet).
+  bool resolve(const uint64_t* macs, size_t n, Resolved* out);
+
+  const std::string* vendor(uint32_t vendorId) const;
+
+private:
+  std::string path_;
+  int fd_ = -1;
+  uint32_t generation_ = 0;
+  std::string error_;
+  std::vector<uint8_t> buf_;
+  std::vector<Record> records_;
+  std::unordered_map<uint32_t, std::string> vendors_;
+
+  bool exchange(uint16_t op, uint32_t count, FrameHeader& resp);
+  bool fetch_vendors(const std::vector<uint32_t>& ids);
+  bool fail(const std::string& msg);
+};
+
+} // namespace ipc
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Binary lookup protocol spoken over the local unix socket.
+//
+// Every message starts with a 12-byte little-endian frame header:
+//   u32 magic   ('OUIB')
+//   u16 op
+//   u16 status  (0 in requests)
+//   u32 count
+//
+// OP_LOOKUP   request : count * 6-byte MACs (network byte order)
+//             response: u32 generation, then count * Record
+// OP_VENDORS  request : count * u32 vendor id
+//             response: u32 generation, then count * (u32 len, len bytes)
+//
+// Vendor ids are only meaningful for the generation they were returned with;
+// clients drop cached vendor names when the generation changes.
+namespace ipc {
+
+constexpr uint32_t kMagic = 0x4249554fu; // "OUIB"
+constexpr size_t kHeaderSize = 12;
+constexpr size_t kMacSize = 6;
+constexpr size_t kRecordSize = 8;
+constexpr uint32_t kMaxCount = 1u << 20;
+constexpr uint32_t kNoVendor = 0xFFFFFFFFu;
+
+enum Op : uint16_t {
+  OP_LOOKUP = 1,
+  OP_VENDORS = 2,
+};
+
+enum Status : uint16_t {
+  STATUS_OK = 0,
+  STATUS_BAD_REQUEST = 1,
+  STATUS_TOO_LARGE = 2,
+  STATUS_UNAVAILABLE = 3,
+};
+
+struct FrameHeader {
+  uint32_t magic = kMagic;
+  uint16_t op = 0;
+  uint16_t status = STATUS_OK;
+  uint32_t count = 0;
+};
+
+// Wire record for one MAC: vendorId == kNoVendor means no match.
+struct Record {
+  uint32_t vendorId = kNoVendor;
+  uint8_t maskBits = 0;
+};
+
+inline void put_u16(uint8_t* p, uint16_t v) {
+  p[0] = static_cast<uint8_t>(v);
+  p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+inline void put_u32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+inline uint16_t get_u16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t get_u32(const uint8_t* p) {
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline void encode_header(uint8_t* p, const FrameHeader& h) {
+  put_u32(p, h.magic);
+  put_u16(p + 4, h.op);
+  put_u16(p + 6, h.status);
+  put_u32(p + 8, h.count);
+}
+
+inline FrameHeader decode_header(const uint8_t* p) {
+  FrameHeader h;
+  h.magic = get_u32(p);
+  h.op = get_u16(p + 4);
+  h.status = get_u16(p + 6);
+  h.count = get_u32(p + 8);
+  return h;
+}
+
+inline void encode_mac(uint8_t* p, uint64_t mac48) {
+  for (int i = 0; i < 6; i++) p[i] = static_cast<uint8_t>(mac48 >> (8 * (5 - i)));
+}
+
+inline uint64_t decode_mac(const uint8_t* p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 6; i++) v = (v << 8) | p[i];
+  return v;
+}
+
+inline void encode_record(uint8_t* p, const Record& r) {
+  put_u32(p, r.vendorId);
+  p[4] = r.maskBits;
+  p[5] = p[6] = p[7] = 0;
+}
+
+inline Record decode_record(const uint8_t* p) {
+  Record r;
+  r.vendorId = get_u32(p);
+  r.maskBits = p[4];
+  return r;
+}
+
+// Blocking helpers that retry on EINTR / short transfers.
+bool read_full(int fd, void* buf, size_t n);
+bool write_full(int fd, const void* buf, size_t n);
+
+} // namespace ipc
@@ -0,0 +1,188 @@
+#include "ipc/unix_server.h"
+#include "ipc/protocol.h"
+#include "oui/compiled_db.h"
+#include "oui/db_handle.h"
+#include "oui/manuf_db.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace ipc {
+
+UnixServer::UnixServer(std::string socketPath, const oui::ManufDB* db)
+  : path_(std::move(socketPath)), db_(db) {}
+
+UnixServer::UnixServer(std::string socketPath, oui::DbHandle* handle)
+  : path_(std::move(socketPath)), db_(nullptr), handle_(handle) {}
+
+UnixServer::~UnixServer() {
+  if (fd_ >= 0) {
+    ::shutdown(fd_, SHUT_RDWR);
+    ::close(fd_);
+    ::unlink(path_.c_str());
+  }
+  if (acceptThread_.joinable()) acceptThread_.join();
+  // Wake connection threads blocked in read and wait until they are gone.
+  std::unique_lock<std::mutex> lock(connMu_);
+  for (int cfd : conns_) ::shutdown(cfd, SHUT_RDWR);
+  connCv_.wait(lock, [&] { return conns_.empty(); });
+}
+
+bool UnixServer::start(std::string& err) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path_.empty() || path_.size() >= sizeof(addr.sun_path)) {
+    err = "invalid unix socket path: " + path_;
+    return false;
+  }
+  std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+
+  // A leftover socket file from a previous run would make bind() fail; any
+  // other file there (a mistyped --unix) is left alone.
+  struct stat st {};
+  if (::lstat(path_.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      err = path_ + ": path exists and is not a socket";
+      return false;
+    }
+    ::unlink(path_.c_str());
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    err = "socket(AF_UNIX) failed";
+    return false;
+  }
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    err = "bind() failed for " + path_ + ": " + std::strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  if (::listen(fd, 64) != 0) {
+    err = "listen() failed for " + path_;
+    ::close(fd);
+    ::unlink(path_.c_str());
+    return false;
+  }
+
+  fd_ = fd;
+  acceptThread_ = std::thread([this] { accept_loop(); });
+  return true;
+}
+
+void UnixServer::accept_loop() {
+  while (true) {
+    int cfd = ::accept(fd_, nullptr, nullptr);
+    if (cfd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      return; // listener closed
+    }
+    {
+      std::lock_guard<std::mutex> lock(connMu_);
+      conns_.insert(cfd);
+    }
+    std::thread([this, cfd] {
+      serve_connection(cfd);
+      // Last touch of this: the destructor may run as soon as the lock drops.
+      std::lock_guard<std::mutex> lock(connMu_);
+      conns_.erase(cfd);
+      ::close(cfd);
+      connCv_.notify_all();
+    }).detach();
+  }
+}
+
+static bool send_status(int fd, uint16_t op, uint16_t status) {
+  uint8_t hdr[kHeaderSize];
+  FrameHeader h;
+  h.op = op;
+  h.status = status;
+  encode_header(hdr, h);
+  return write_full(fd, hdr, sizeof(hdr));
+}
+
+// Response frame for a request whose items are in `in`.
+static void answer(const oui::ManufDB& db, uint32_t generation, const FrameHeader& req,
+                   const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+  auto image = db.compiled();
+  if (!image) {
+    FrameHeader h;
+    h.op = req.op;
+    h.status = STATUS_UNAVAILABLE;
+    out.resize(kHeaderSize);
+    encode_header(out.data(), h);
+    return;
+  }
+
+  FrameHeader resp;
+  resp.op = req.op;
+  resp.count = req.count;
+  out.resize(kHeaderSize + 4);
+  encode_header(out.data(), resp);
+  put_u32(out.data() + kHeaderSize, generation);
+
+  if (req.op == OP_LOOKUP) {
+    out.resize(kHeaderSize + 4 + size_t(req.count) * kRecordSize);
+    uint8_t* rec = out.data() + kHeaderSize + 4;
+    for (uint32_t i = 0; i < req.count; i++, rec += kRecordSize) {
+      Record r;
+      if (const oui::ImageEntry* e = image->find(decode_mac(in.data() + i * kMacSize))) {
+        r.vendorId = e->vendorId;
+        r.maskBits = static_cast<uint8_t>(e->maskBits);
+      }
+      encode_record(rec, r);
+    }
+  } else {
+    for (uint32_t i = 0; i < req.count; i++) {
+      std::string_view v = image->vendor(get_u32(in.data() + i * 4));
+      size_t at = out.size();
+      out.resize(at + 4 + v.size());
+      put_u32(out.data() + at, static_cast<uint32_t>(v.size()));
+      std::memcpy(out.data() + at + 4, v.data(), v.size());
+    }
+  }
+}
+
+void UnixServer::serve_connection(int cfd) {
+  std::vector<uint8_t> in;
+  std::vector<uint8_t> out;
+  uint8_t hdr[kHeaderSize];
+  std::optional<oui::DbHandle::Reader> reader;
+  if (handle_) reader.emplace(handle_->reader());
+
+  while (read_full(cfd, hdr, sizeof(hdr))) {
+    FrameHeader req = decode_header(hdr);
+    if (req.magic != kMagic || (req.op != OP_LOOKUP && req.op != OP_VENDORS)) {
+      send_status(cfd, req.op, STATUS_BAD_REQUEST);
+      break;
+    }
+    if (req.count > kMaxCount) {
+      send_status(cfd, req.op, STATUS_TOO_LARGE);
+      break;
+    }
+
+    const size_t itemSize = req.op == OP_LOOKUP ? kMacSize : 4;
+    in.resize(size_t(req.count) * itemSize);
+    if (!read_full(cfd, in.data(), in.size())) break;
+
+    // The handle's version number is the generation: a swap invalidates
+    // the vendor ids clients have cached.
+    if (reader) {
+      reader->with([&](const oui::ManufDB& db, uint64_t version) {
+        answer(db, static_cast<uint32_t>(version), req, in, out);
+      });
+    } else {
+      answer(*db_, generation_, req, in, out);
+    }
+    if (!write_full(cfd, out.data(), out.size())) break;
+  }
+}
+
+} // namespace ipc
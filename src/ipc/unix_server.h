@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace oui {
+class DbHandle;
+class ManufDB;
+} // namespace oui
+
+namespace ipc {
+
+// Local listener for the binary protocol in ipc/protocol.h. Runs on its own
+// accept thread with one thread per connection, next to the HTTP server.
+// The destructor shuts down open connections and waits for their threads,
+// so none outlives the DB (or DbHandle) it reads.
+class UnixServer {
+public:
+  UnixServer(std::string socketPath, const oui::ManufDB* db);
+  // Answers from the current version of handle, which is also the
+  // generation sent with every response.
+  UnixServer(std::string socketPath, oui::DbHandle* handle);
+  ~UnixServer();
+
+  UnixServer(const UnixServer&) = delete;
+  UnixServer& operator=(const UnixServer&) = delete;
+
+  bool start(std::string& err);
+
+private:
+  std::string path_;
+  const oui::ManufDB* db_;
+  oui::DbHandle* handle_ = nullptr;
+  int fd_ = -1;
+  uint32_t generation_ = 1;
+  std::thread acceptThread_;
+  std::mutex connMu_;
+  std::condition_variable connCv_;
+  std::set<int> conns_; // fds with a live connection thread
+
+  void accept_loop();
+  void serve_connection(int cfd);
+};
+
+} // namespace ipc
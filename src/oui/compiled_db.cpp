@@ -0,0 +1,222 @@
+#include "oui/compiled_db.h"
+#include "oui/mac.h"
+#include "oui/manuf_db.h"
+#include "util/fs.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace oui {
+
+static const char kImageMagic[8] = {'O', 'U', 'I', 'I', 'M', 'G', '1', '\0'};
+
+template <typename T>
+static void append_pod(std::string& out, const T& v) {
+  out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+std::string CompiledDB::serialize(const std::vector<const Entry*>& input) {
+  std::vector<const Entry*> sorted(input);
+  std::sort(sorted.begin(), sorted.end(), [](const Entry* a, const Entry* b) {
+    if (a->maskBits != b->maskBits) return a->maskBits > b->maskBits;
+    return a->prefix < b->prefix;
+  });
+
+  std::string strings;
+  std::vector<ImageString> vendors;
+  std::unordered_map<std::string, uint32_t> vendorIds;
+  auto intern = [&](const std::string& s) {
+    ImageString ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(s.size())};
+    strings += s;
+    strings.push_back('\0'); // so C callers can use the pool directly
+    return ref;
+  };
+
+  std::vector<ImageMask> masks;
+  std::vector<ImageEntry> entries;
+  entries.reserve(sorted.size());
+  for (const Entry* e : sorted) {
+    if (masks.empty() || masks.back().bits != e->maskBits) {
+      masks.push_back({e->maskBits, static_cast<uint32_t>(entries.size()), 0, 0});
+    }
+    masks.back().count++;
+
+    auto it = vendorIds.find(e->vendor);
+    if (it == vendorIds.end()) {
+      it = vendorIds.emplace(e->vendor, static_cast<uint32_t>(vendors.size())).first;
+      vendors.push_back(intern(e->vendor));
+    }
+
+    ImageEntry ie{};
+    ie.prefix = e->prefix;
+    ie.vendorId = it->second;
+    if (!e->comment.empty()) {
+      ImageString c = intern(e->comment);
+      ie.commentOff = c.off;
+      ie.commentLen = c.len;
+    }
+    ie.maskBits = e->maskBits;
+    entries.push_back(ie);
+  }
+
+  ImageHeader h{};
+  std::memcpy(h.magic, kImageMagic, sizeof(h.magic));
+  h.version = CompiledDB::kVersion;
+  h.maskCount = static_cast<uint32_t>(masks.size());
+  h.entryCount = static_cast<uint32_t>(entries.size());
+  h.vendorCount = static_cast<uint32_t>(vendors.size());
+  h.stringsSize = strings.size();
+  h.totalSize = sizeof(ImageHeader) + masks.size() * sizeof(ImageMask) +
+                entries.size() * sizeof(ImageEntry) + vendors.size() * sizeof(ImageString) +
+                strings.size();
+
+  std::string out;
+  out.reserve(h.totalSize);
+  append_pod(out, h);
+  for (const auto& m : masks) append_pod(out, m);
+  for (const auto& e : entries) append_pod(out, e);
+  for (const auto& v : vendors) append_pod(out, v);
+  out += strings;
+  return out;
+}
+
+std::shared_ptr<const CompiledDB> CompiledDB::from_buffer(std::string image) {
+  std::shared_ptr<CompiledDB> db(new CompiledDB());
+  db->owned_ = std::move(image);
+  if (!db->bind(db->owned_.data(), db->owned_.size())) return nullptr;
+  return db;
+}
+
+std::shared_ptr<const CompiledDB> CompiledDB::from_memory(const void* data, size_t size,
+                                                          std::shared_ptr<const void> keepAlive) {
+  std::shared_ptr<CompiledDB> db(new CompiledDB());
+  db->keepAlive_ = std::move(keepAlive);
+  if (!db->bind(data, size)) return nullptr;
+  return db;
+}
+
+std::shared_ptr<const CompiledDB> CompiledDB::open_file(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) return nullptr;
+
+  std::shared_ptr<const void> keep(p, [size](const void* q) {
+    ::munmap(const_cast<void*>(q), size);
+  });
+  return from_memory(p, size, std::move(keep));
+}
+
+bool CompiledDB::save(const std::string& path) const {
+  const std::string tmp = path + ".tmp";
+  std::FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) return false;
+  bool ok = std::fwrite(base_, 1, size_, f) == size_;
+  ok = (std::fclose(f) == 0) && ok;
+  if (!ok || !util::fs::atomic_replace(tmp, path)) {
+    util::fs::remove_file(tmp);
+    return false;
+  }
+  return true;
+}
+
+bool CompiledDB::bind(const void* data, size_t size) {
+  if (!data || size < sizeof(ImageHeader)) return false;
+  if (reinterpret_cast<uintptr_t>(data) % alignof(ImageEntry) != 0) return false;
+
+  const auto* h = static_cast<const ImageHeader*>(data);
+  if (std::memcmp(h->magic, kImageMagic, sizeof(kImageMagic)) != 0) return false;
+  if (h->version != CompiledDB::kVersion) return false;
+
+  const uint64_t need = sizeof(ImageHeader) + uint64_t(h->maskCount) * sizeof(ImageMask) +
+                        uint64_t(h->entryCount) * sizeof(ImageEntry) +
+                        uint64_t(h->vendorCount) * sizeof(ImageString) + h->stringsSize;
+  if (need != h->totalSize || need > size) return false;
+
+  base_ = static_cast<const uint8_t*>(data);
+  size_ = h->totalSize;
+  header_ = h;
+  masks_ = reinterpret_cast<const ImageMask*>(base_ + sizeof(ImageHeader));
+  entries_ = reinterpret_cast<const ImageEntry*>(masks_ + h->maskCount);
+  vendors_ = reinterpret_cast<const ImageString*>(entries_ + h->entryCount);
+  strings_ = reinterpret_cast<const char*>(vendors_ + h->vendorCount);
+
+  for (uint32_t i = 0; i < h->maskCount; i++) {
+    if (uint64_t(masks_[i].first) + masks_[i].count > h->entryCount) return false;
+  }
+  for (uint32_t i = 0; i < h->vendorCount; i++) {
+    if (uint64_t(vendors_[i].off) + vendors_[i].len >= h->stringsSize) return false;
+    if (strings_[vendors_[i].off + vendors_[i].len] != '\0') return false;
+  }
+  for (uint32_t i = 0; i < h->entryCount; i++) {
+    const ImageEntry& e = entries_[i];
+    if (e.vendorId >= h->vendorCount) return false;
+    if (e.commentLen == 0) continue;
+    if (uint64_t(e.commentOff) + e.commentLen >= h->stringsSize) return false;
+    if (strings_[e.commentOff + e.commentLen] != '\0') return false;
+  }
+  return true;
+}
+
+const ImageEntry* CompiledDB::find(uint64_t mac48) const {
+  for (uint32_t i = 0; i < header_->maskCount; i++) {
+    if (const ImageEntry* e = find_at(i, mac48 & mask48(masks_[i].bits))) return e;
+  }
+  return nullptr;
+}
+
+const ImageEntry* CompiledDB::find_at(uint32_t maskIndex, uint64_t key) const {
+  const ImageMask& m = masks_[maskIndex];
+  const ImageEntry* first = entries_ + m.first;
+  const ImageEntry* last = first + m.count;
+  const ImageEntry* it = std::lower_bound(first, last, key,
+    [](const ImageEntry& e, uint64_t k) { return e.prefix < k; });
+  return (it != last && it->prefix == key) ? it : nullptr;
+}
+
+std::pair<const ImageEntry*, const ImageEntry*> CompiledDB::range_at(uint32_t maskIndex, uint64_t lo,
+                                                                     uint64_t hi) const {
+  const ImageMask& m = masks_[maskIndex];
+  const ImageEntry* first = entries_ + m.first;
+  const ImageEntry* last = first + m.count;
+  first = std::lower_bound(first, last, lo,
+    [](const ImageEntry& e, uint64_t k) { return e.prefix < k; });
+  last = std::upper_bound(first, last, hi,
+    [](uint64_t k, const ImageEntry& e) { return k < e.prefix; });
+  return {first, last};
+}
+
+std::string_view CompiledDB::vendor(uint32_t vendorId) const {
+  if (vendorId >= header_->vendorCount) return {};
+  const ImageString& s = vendors_[vendorId];
+  return std::string_view(strings_ + s.off, s.len);
+}
+
+std::string_view CompiledDB::comment(const ImageEntry& e) const {
+  return std::string_view(strings_ + e.commentOff, e.commentLen);
+}
+
+Entry CompiledDB::to_entry(const ImageEntry& e) const {
+  Entry out;
+  out.prefix = e.prefix;
+  out.maskBits = e.maskBits;
+  out.vendor = std::string(vendor(e.vendorId));
+  out.comment = std::string(comment(e));
+  return out;
+}
+
+} // namespace oui
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace oui {
+
+struct Entry;
+
+// Flat, position-independent image of the DB. Entries are grouped by mask
+// (descending) and sorted by prefix inside each group, so the whole image can
+// be shared between processes or written to disk as-is.
+struct ImageHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t maskCount;
+  uint32_t entryCount;
+  uint32_t vendorCount;
+  uint64_t stringsSize;
+  uint64_t totalSize;
+};
+
+struct ImageMask {
+  int32_t bits;
+  uint32_t first; // index into entries
+  uint32_t count;
+  uint32_t reserved;
+};
+
+struct ImageEntry {
+  uint64_t prefix;
+  uint32_t vendorId;
+  uint32_t commentOff;
+  uint32_t commentLen;
+  int32_t maskBits;
+};
+
+// Strings in the pool are NUL-terminated; len excludes the terminator.
+struct ImageString {
+  uint32_t off;
+  uint32_t len;
+};
+
+class CompiledDB {
+public:
+  // ImageHeader::version this build writes and reads.
+  static constexpr uint32_t kVersion = 2;
+
+  // Serializes entries (any order, unique per mask/prefix) into an image.
+  static std::string serialize(const std::vector<const Entry*>& entries);
+  // Takes ownership of a serialized image.
+  static std::shared_ptr<const CompiledDB> from_buffer(std::string image);
+  // Wraps memory owned elsewhere (e.g. a mapping); keepAlive pins it.
+  static std::shared_ptr<const CompiledDB> from_memory(const void* data, size_t size,
+                                                       std::shared_ptr<const void> keepAlive);
+  // Maps an image written by save(); null if missing or invalid.
+  static std::shared_ptr<const CompiledDB> open_file(const std::string& path);
+  bool save(const std::string& path) const;
+
+  const void* data() const { return base_; }
+  size_t size() const { return size_; }
+
+  uint32_t mask_count() const { return header_->maskCount; }
+  uint32_t entry_count() const { return header_->entryCount; }
+  uint32_t vendor_count() const { return header_->vendorCount; }
+  const ImageMask* masks() const { return masks_; }
+  const ImageEntry* entries() const { return entries_; }
+
+  // Longest prefix match; nullptr when nothing covers mac48.
+  const ImageEntry* find(uint64_t mac48) const;
+  // Exact (already masked) key within masks()[maskIndex].
+  const ImageEntry* find_at(uint32_t maskIndex, uint64_t key) const;
+  // Entries of masks()[maskIndex] with lo <= prefix <= hi, as [first, last).
+  std::pair<const ImageEntry*, const ImageEntry*> range_at(uint32_t maskIndex, uint64_t lo,
+                                                           uint64_t hi) const;
+
+  std::string_view vendor(uint32_t vendorId) const;
+  std::string_view comment(const ImageEntry& e) const;
+  Entry to_entry(const ImageEntry& e) const;
+
+private:
+  CompiledDB() = default;
+  bool bind(const void* data, size_t size);
+
+  std::string owned_;
+  std::shared_ptr<const void> keepAlive_;
+  const uint8_t* base_ = nullptr;
+  size_t size_ = 0;
+  const ImageHeader* header_ = nullptr;
+  const ImageMask* masks_ = nullptr;
+  const ImageEntry* entries_ = nullptr;
+  const ImageString* vendors_ = nullptr;
+  const char* strings_ = nullptr;
+};
+
+} // namespace oui
@@ -0,0 +1,122 @@
+#include "oui/db_handle.h"
+
+namespace oui {
+
+// One per reader. epoch is 0 while the reader is outside a lookup, otherwise
+// the global epoch observed when it pinned the current version.
+struct alignas(64) DbHandle::Slot {
+  std::atomic<uint64_t> epoch{0};
+  std::atomic<bool> inUse{false};
+  Slot* next = nullptr;
+};
+
+DbHandle::DbHandle() : DbHandle(nullptr) {}
+
+DbHandle::DbHandle(std::unique_ptr<const ManufDB> db) {
+  publish(std::move(db));
+}
+
+DbHandle::~DbHandle() {
+  // Readers must be gone by now, so everything is unreachable.
+  for (const Retired& r : retired_) delete r.v;
+  delete current_.load();
+  for (Slot* s = slots_.load(); s;) {
+    Slot* next = s->next;
+    delete s;
+    s = next;
+  }
+}
+
+DbHandle::Slot* DbHandle::acquire_slot() {
+  for (Slot* s = slots_.load(std::memory_order_acquire); s; s = s->next) {
+    bool expected = false;
+    if (!s->inUse.load(std::memory_order_relaxed) &&
+        s->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+      return s;
+    }
+  }
+  Slot* s = new Slot();
+  s->inUse.store(true, std::memory_order_relaxed);
+  Slot* head = slots_.load(std::memory_order_relaxed);
+  do {
+    s->next = head;
+  } while (!slots_.compare_exchange_weak(head, s, std::memory_order_release,
+                                         std::memory_order_relaxed));
+  return s;
+}
+
+DbHandle::Reader DbHandle::reader() {
+  return Reader(this, acquire_slot());
+}
+
+DbHandle::Reader::Reader(Reader&& other) noexcept
+  : handle_(other.handle_), slot_(other.slot_) {
+  other.slot_ = nullptr;
+}
+
+DbHandle::Reader::~Reader() {
+  if (slot_) slot_->inUse.store(false, std::memory_order_release);
+}
+
+// The writer swaps current_ before advancing the epoch and only then scans
+// the slots (all seq_cst). A reader that announces epoch e and then loads
+// current_ can therefore only see versions retired at epoch >= e.
+DbHandle::Reader::Pin::Pin(Reader& r) : slot(r.slot_) {
+  slot->epoch.store(r.handle_->epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+  v = r.handle_->current_.load(std::memory_order_seq_cst);
+}
+
+DbHandle::Reader::Pin::~Pin() {
+  slot->epoch.store(0, std::memory_order_release);
+}
+
+LookupResult DbHandle::Reader::lookup(uint64_t mac48) {
+  return with([&](const ManufDB& db, uint64_t) { return db.lookup(mac48); });
+}
+
+LookupResult DbHandle::Reader::lookup(const std::string& macOrPrefix) {
+  return with([&](const ManufDB& db, uint64_t) { return db.lookup(macOrPrefix); });
+}
+
+uint64_t DbHandle::publish(std::unique_ptr<const ManufDB> db) {
+  auto* v = new Version();
+  v->db = db ? std::move(db) : std::unique_ptr<const ManufDB>(new ManufDB());
+  std::lock_guard<std::mutex> lock(writerMu_);
+  v->number = nextNumber_++;
+  const Version* old = current_.exchange(v, std::memory_order_seq_cst);
+  if (old) retired_.push_back({old, epoch_.fetch_add(1, std::memory_order_seq_cst)});
+  reclaim_locked();
+  return v->number;
+}
+
+size_t DbHandle::reclaim() {
+  std::lock_guard<std::mutex> lock(writerMu_);
+  return reclaim_locked();
+}
+
+size_t DbHandle::reclaim_locked() {
+  if (retired_.empty()) return 0;
+  // Oldest epoch any reader is still inside; versions retired before it are
+  // unreachable.
+  uint64_t oldest = UINT64_MAX;
+  for (Slot* s = slots_.load(std::memory_order_acquire); s; s = s->next) {
+    const uint64_t e = s->epoch.load(std::memory_order_seq_cst);
+    if (e != 0 && e < oldest) oldest = e;
+  }
+  size_t kept = 0;
+  for (const Retired& r : retired_) {
+    if (r.epoch < oldest) {
+      delete r.v;
+    } else {
+      retired_[kept++] = r;
+    }
+  }
+  retired_.resize(kept);
+  return kept;
+}
+
+uint64_t DbHandle::version() const {
+  return current_.load(std::memory_order_acquire)->number;
+}
+
+} // namespace oui
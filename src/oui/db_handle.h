@@ -0,0 +1,103 @@
+#pragma once
+#include "oui/manuf_db.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace oui {
+
+// Multi-version handle for sharing a DB between threads.
+//
+// A ManufDB is safe for concurrent const calls but load()/attach() modify it
+// in place. DbHandle instead holds immutable versions: a writer builds a new
+// ManufDB and publish()es it, readers keep doing lookups on whichever version
+// was current when their lookup started. Old versions are freed once no
+// reader can still see them (epoch-based reclamation).
+//
+// Reader lookups are wait-free: a fixed number of atomic loads and stores
+// around the lookup itself, no locks, no retries. publish() and reclaim()
+// serialise writers on a mutex.
+class DbHandle {
+  struct Slot;
+  struct Version;
+
+public:
+  DbHandle();
+  explicit DbHandle(std::unique_ptr<const ManufDB> db);
+  ~DbHandle();
+
+  DbHandle(const DbHandle&) = delete;
+  DbHandle& operator=(const DbHandle&) = delete;
+
+  // Per-thread access point. Not thread-safe itself: create one per reader
+  // thread (cheap; slots are reused after a Reader is destroyed). Must not
+  // outlive the handle.
+  class Reader {
+  public:
+    Reader(Reader&& other) noexcept;
+    Reader& operator=(Reader&&) = delete;
+    ~Reader();
+
+    LookupResult lookup(uint64_t mac48);
+    LookupResult lookup(const std::string& macOrPrefix);
+
+    // Calls fn(const ManufDB&, version) with the current version pinned;
+    // references into the DB must not escape fn.
+    template <typename F>
+    auto with(F&& fn) {
+      Pin pin(*this);
+      return fn(*pin.v->db, pin.v->number);
+    }
+
+  private:
+    friend class DbHandle;
+    Reader(DbHandle* handle, Slot* slot) : handle_(handle), slot_(slot) {}
+
+    struct Pin {
+      explicit Pin(Reader& r);
+      ~Pin();
+      Slot* slot;
+      const Version* v;
+    };
+
+    DbHandle* handle_;
+    Slot* slot_;
+  };
+
+  Reader reader();
+
+  // Makes db the current version; returns its version number (1, 2, ...).
+  // Versions no reader can see any more are freed before returning.
+  uint64_t publish(std::unique_ptr<const ManufDB> db);
+  // Frees unreachable old versions; returns how many are still pending.
+  size_t reclaim();
+
+  uint64_t version() const;
+
+private:
+  struct Version {
+    std::unique_ptr<const ManufDB> db;
+    uint64_t number = 0;
+  };
+  struct Retired {
+    const Version* v;
+    uint64_t epoch; // global epoch when it stopped being current
+  };
+
+  std::atomic<const Version*> current_{nullptr};
+  std::atomic<uint64_t> epoch_{1};
+  std::atomic<Slot*> slots_{nullptr}; // lock-free list; nodes live as long as the handle
+
+  std::mutex writerMu_;
+  std::vector<Retired> retired_;
+  uint64_t nextNumber_ = 1;
+
+  Slot* acquire_slot();
+  size_t reclaim_locked();
+};
+
+} // namespace oui
@@ -0,0 +1,111 @@
+#include "oui/explain.h"
+#include "oui/mac.h"
+
+#include <sstream>
+
+namespace oui {
+
+static util::json::Value nanos(uint64_t ns) {
+  return util::json::Value(static_cast<int>(ns > 0x7fffffff ? 0x7fffffff : ns));
+}
+
+util::json::Object explain_to_json(const Explain& ex) {
+  util::json::Object obj;
+  obj["parsed"] = util::json::Value(ex.parsed);
+  obj["parse_ns"] = nanos(ex.parseNanos);
+  obj["total_ns"] = nanos(ex.totalNanos);
+  if (!ex.parsed) return obj;
+
+  obj["input"] = util::json::Value(prefix_to_string(ex.mac48, 48));
+  obj["input_bits"] = util::json::Value(ex.inputBits);
+
+  util::json::Array steps;
+  for (const auto& s : ex.steps) {
+    util::json::Object o;
+    o["mask_bits"] = util::json::Value(s.maskBits);
+    o["key"] = util::json::Value(prefix_to_string(s.key, s.maskBits));
+    o["result"] = util::json::Value(!s.hit ? "miss" : (s.shadowed ? "shadowed" : "hit"));
+    if (s.hit) o["vendor"] = util::json::Value(s.vendor);
+    o["ns"] = nanos(s.nanos);
+    steps.push_back(util::json::Value(o));
+  }
+  obj["probes"] = util::json::Value(steps);
+
+  util::json::Array dropped;
+  for (const auto& ow : ex.overwrites) {
+    util::json::Object o;
+    o["prefix"] = util::json::Value(prefix_to_string(ow.prefix, ow.maskBits));
+    o["mask_bits"] = util::json::Value(ow.maskBits);
+    o["line"] = util::json::Value(static_cast<int>(ow.line));
+    o["vendor"] = util::json::Value(ow.vendor);
+    o["dropped_line"] = util::json::Value(static_cast<int>(ow.previousLine));
+    o["dropped_vendor"] = util::json::Value(ow.previousVendor);
+    dropped.push_back(util::json::Value(o));
+  }
+  obj["overwritten"] = util::json::Value(dropped);
+  return obj;
+}
+
+std::string explain_to_text(const Explain& ex) {
+  std::ostringstream oss;
+  if (!ex.parsed) {
+    oss << "Input: not a MAC or prefix (parse " << ex.parseNanos << " ns)\n";
+    return oss.str();
+  }
+  oss << "Input: " << prefix_to_string(ex.mac48, 48) << " (" << ex.inputBits
+      << " bits given, parse " << ex.parseNanos << " ns)\n";
+  for (const auto& s : ex.steps) {
+    oss << "  /" << s.maskBits << " " << prefix_to_string(s.key, s.maskBits) << "  "
+        << (!s.hit ? "miss" : (s.shadowed ? "shadowed" : "HIT"));
+    if (s.hit) oss << "  " << s.vendor;
+    oss << "  (" << s.nanos << " ns)\n";
+  }
+  for (const auto& ow : ex.overwrites) {
+    oss << "  overwritten at load: " << prefix_to_string(ow.prefix, ow.maskBits) << "/"
+        << ow.maskBits << " line " << ow.previousLine << " (" << ow.previousVendor
+        << ") replaced by line " << ow.line << " (" << ow.vendor << ")\n";
+  }
+  oss << "Total: " << ex.totalNanos << " ns\n";
+  return oss.str();
+}
+
+util::json::Object range_to_json(const RangeResult& r) {
+  util::json::Object obj;
+  obj["parsed"] = util::json::Value(r.parsed);
+  if (!r.parsed) return obj;
+  obj["prefix"] = util::json::Value(prefix_to_string(r.prefix, r.maskBits));
+  obj["mask_bits"] = util::json::Value(r.maskBits);
+  obj["total"] = util::json::Value(static_cast<int64_t>(r.total));
+  obj["offset"] = util::json::Value(static_cast<int64_t>(r.offset));
+
+  util::json::Array entries;
+  for (const auto& e : r.entries) {
+    util::json::Object o;
+    o["prefix"] = util::json::Value(prefix_to_string(e.prefix, e.maskBits));
+    o["mask_bits"] = util::json::Value(e.maskBits);
+    o["vendor"] = util::json::Value(e.vendor);
+    o["comment"] = util::json::Value(e.comment);
+    entries.push_back(util::json::Value(o));
+  }
+  obj["entries"] = util::json::Value(entries);
+  return obj;
+}
+
+std::string range_to_text(const RangeResult& r) {
+  std::ostringstream oss;
+  if (!r.parsed) {
+    oss << "Invalid prefix\n";
+    return oss.str();
+  }
+  for (const auto& e : r.entries) {
+    oss << prefix_to_string(e.prefix, e.maskBits) << "/" << e.maskBits << "\t" << e.vendor;
+    if (!e.comment.empty()) oss << "\t" << e.comment;
+    oss << "\n";
+  }
+  const size_t first = r.entries.empty() ? r.offset : r.offset + 1;
+  oss << "Entries " << first << "-" << r.offset + r.entries.size() << " of " << r.total
+      << " under " << prefix_to_string(r.prefix, r.maskBits) << "/" << r.maskBits << "\n";
+  return oss.str();
+}
+
+} // namespace oui
@@ -0,0 +1,14 @@
+#pragma once
+#include "oui/manuf_db.h"
+#include "util/json.h"
+
+#include <string>
+
+namespace oui {
+// Renderings of ManufDB::explain() and lookup_all() shared by the CLI and
+// the HTTP API.
+util::json::Object explain_to_json(const Explain& ex);
+std::string explain_to_text(const Explain& ex);
+util::json::Object range_to_json(const RangeResult& r);
+std::string range_to_text(const RangeResult& r);
+}
@@ -0,0 +1,351 @@
+#include "oui/format.h"
+#include "oui/compiled_db.h"
+#include "oui/mac.h"
+#include "oui/manuf_db.h"
+
+namespace oui::fmt {
+
+Record from_image(const CompiledDB& db, const ImageEntry* hit, std::string_view input) {
+  Record r;
+  r.input = input;
+  if (!hit) return r;
+  r.found = true;
+  r.prefix = hit->prefix;
+  r.maskBits = hit->maskBits;
+  r.vendor = db.vendor(hit->vendorId);
+  r.comment = db.comment(*hit);
+  return r;
+}
+
+Record from_result(const LookupResult& lr, std::string_view input) {
+  Record r;
+  r.input = input;
+  if (!lr.found) return r;
+  r.found = true;
+  r.prefix = lr.entry.prefix;
+  r.maskBits = lr.entry.maskBits;
+  r.vendor = lr.entry.vendor;
+  r.comment = lr.entry.comment;
+  return r;
+}
+
+// Fields fixed at compile time, or kDynamic to test the runtime mask.
+constexpr unsigned kDynamic = ~0u;
+
+template <unsigned F>
+inline bool has(unsigned fields, Field f) {
+  if constexpr (F == kDynamic) {
+    return (fields & f) != 0;
+  } else {
+    (void)fields;
+    return (F & f) != 0;
+  }
+}
+
+static void append_uint(std::string& out, uint64_t v) {
+  char buf[20];
+  size_t n = 0;
+  do {
+    buf[n++] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  } while (v);
+  while (n) out.push_back(buf[--n]);
+}
+
+static bool json_plain(char c) {
+  return static_cast<unsigned char>(c) >= 0x20 && c != '"' && c != '\\';
+}
+
+// Copies runs of plain characters in one append; escapes the rest.
+static void json_string(std::string& out, std::string_view s) {
+  static const char kHex[] = "0123456789abcdef";
+  out.push_back('"');
+  size_t i = 0;
+  while (i < s.size()) {
+    size_t run = i;
+    while (run < s.size() && json_plain(s[run])) run++;
+    out.append(s.data() + i, run - i);
+    if (run == s.size()) break;
+    const char c = s[run];
+    switch (c) {
+      case '\\': out += "\\\\"; break;
+      case '"':  out += "\\\""; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        out += "\\u00";
+        out.push_back(kHex[(c >> 4) & 0xF]);
+        out.push_back(kHex[c & 0xF]);
+    }
+    i = run + 1;
+  }
+  out.push_back('"');
+}
+
+template <unsigned F>
+static void write_text(const Record& r, unsigned fields, std::string& out) {
+  if (has<F>(fields, Input)) {
+    out += "Input: ";
+    out += r.input;
+    out.push_back('\n');
+  }
+  if (!r.found) {
+    out += "No match\n";
+    return;
+  }
+  if (has<F>(fields, Vendor)) {
+    out += "Vendor: ";
+    out += r.vendor;
+    out.push_back('\n');
+  }
+  if (has<F>(fields, Prefix)) {
+    out += "Prefix: ";
+    append_prefix(out, r.prefix, r.maskBits);
+    if (has<F>(fields, MaskBits)) {
+      out.push_back('/');
+      append_uint(out, static_cast<uint64_t>(r.maskBits));
+    }
+    out.push_back('\n');
+  } else if (has<F>(fields, MaskBits)) {
+    out += "Mask bits: ";
+    append_uint(out, static_cast<uint64_t>(r.maskBits));
+    out.push_back('\n');
+  }
+  if (has<F>(fields, Comment) && !r.comment.empty()) {
+    out += "Comment: ";
+    out += r.comment;
+    out.push_back('\n');
+  }
+  if (has<F>(fields, Db)) {
+    out += "DB: ";
+    out += r.db;
+    out.push_back('\n');
+  }
+}
+
+template <unsigned F, bool Lines>
+static void write_json(const Record& r, unsigned fields, std::string& out) {
+  bool first = true;
+  auto key = [&](const char* k) {
+    out += first ? "{\"" : ",\"";
+    first = false;
+    out += k;
+    out += "\":";
+  };
+  if (has<F>(fields, Input)) {
+    key("input");
+    json_string(out, r.input);
+  }
+  if (has<F>(fields, Found)) {
+    key("found");
+    out += r.found ? "true" : "false";
+  }
+  if (r.found) {
+    if (has<F>(fields, Vendor)) {
+      key("vendor");
+      json_string(out, r.vendor);
+    }
+    if (has<F>(fields, Prefix)) {
+      key("prefix");
+      out.push_back('"');
+      append_prefix(out, r.prefix, r.maskBits);
+      out.push_back('"');
+    }
+    if (has<F>(fields, MaskBits)) {
+      key("mask_bits");
+      append_uint(out, static_cast<uint64_t>(r.maskBits));
+    }
+    if (has<F>(fields, Comment)) {
+      key("comment");
+      json_string(out, r.comment);
+    }
+    if (has<F>(fields, Db)) {
+      key("db");
+      json_string(out, r.db);
+    }
+  }
+  out += first ? "{}" : "}";
+  if (Lines) out.push_back('\n');
+}
+
+static void csv_value(std::string& out, std::string_view s) {
+  if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+    out += s;
+    return;
+  }
+  out.push_back('"');
+  for (char c : s) {
+    if (c == '"') out.push_back('"');
+    out.push_back(c);
+  }
+  out.push_back('"');
+}
+
+static void tsv_value(std::string& out, std::string_view s) {
+  const size_t start = out.size();
+  out += s;
+  for (size_t i = start; i < out.size(); i++) {
+    if (out[i] == '\t' || out[i] == '\n' || out[i] == '\r') out[i] = ' ';
+  }
+}
+
+template <unsigned F, char Sep>
+static void write_delimited(const Record& r, unsigned fields, std::string& out) {
+  bool first = true;
+  auto sep = [&] {
+    if (!first) out.push_back(Sep);
+    first = false;
+  };
+  auto value = [&](std::string_view s) {
+    if (Sep == ',') csv_value(out, s);
+    else tsv_value(out, s);
+  };
+  if (has<F>(fields, Input)) {
+    sep();
+    value(r.input);
+  }
+  if (has<F>(fields, Found)) {
+    sep();
+    out += r.found ? "true" : "false";
+  }
+  if (has<F>(fields, Prefix)) {
+    sep();
+    if (r.found) append_prefix(out, r.prefix, r.maskBits);
+  }
+  if (has<F>(fields, MaskBits)) {
+    sep();
+    if (r.found) append_uint(out, static_cast<uint64_t>(r.maskBits));
+  }
+  if (has<F>(fields, Vendor)) {
+    sep();
+    if (r.found) value(r.vendor);
+  }
+  if (has<F>(fields, Comment)) {
+    sep();
+    if (r.found) value(r.comment);
+  }
+  if (has<F>(fields, Db)) {
+    sep();
+    if (r.found) value(r.db);
+  }
+  out.push_back('\n');
+}
+
+static void binary_string(std::string& out, std::string_view s) {
+  const size_t n = s.size() > 0xFFFF ? 0xFFFF : s.size();
+  out.push_back(static_cast<char>(n & 0xFF));
+  out.push_back(static_cast<char>(n >> 8));
+  out.append(s.data(), n);
+}
+
+template <unsigned F>
+static void write_binary(const Record& r, unsigned fields, std::string& out) {
+  out.push_back(r.found ? 1 : 0);
+  out.push_back(static_cast<char>(r.found ? r.maskBits : 0));
+  for (int i = 0; i < 6; i++) out.push_back(static_cast<char>(r.found ? (r.prefix >> (8 * i)) & 0xFF : 0));
+  if (has<F>(fields, Input)) binary_string(out, r.input);
+  if (has<F>(fields, Vendor)) binary_string(out, r.found ? r.vendor : std::string_view());
+  if (has<F>(fields, Comment)) binary_string(out, r.found ? r.comment : std::string_view());
+  if (has<F>(fields, Db)) binary_string(out, r.found ? r.db : std::string_view());
+}
+
+using WriteFn = void (*)(const Record&, unsigned, std::string&);
+
+// Indexed by Format.
+template <unsigned F>
+struct Writers {
+  static constexpr WriteFn table[] = {
+    write_text<F>, write_json<F, false>, write_json<F, true>,
+    write_delimited<F, ','>, write_delimited<F, '\t'>, write_binary<F>,
+  };
+};
+
+Writer writer(Format format, unsigned fields) {
+  fields &= AllFields;
+  const size_t i = static_cast<size_t>(format);
+  WriteFn fn;
+  switch (fields) {
+    case kDefaultFields: fn = Writers<kDefaultFields>::table[i]; break;
+    case kApiFields:     fn = Writers<kApiFields>::table[i]; break;
+    case kJoinFields:    fn = Writers<kJoinFields>::table[i]; break;
+    case kBulkFields:    fn = Writers<kBulkFields>::table[i]; break;
+    default:             fn = Writers<kDynamic>::table[i]; break;
+  }
+  return {format, fields, fn};
+}
+
+static const struct {
+  Field field;
+  const char* name;
+} kFieldNames[] = {
+  {Input, "input"}, {Found, "found"}, {Prefix, "prefix"}, {MaskBits, "mask_bits"},
+  {Vendor, "vendor"}, {Comment, "comment"}, {Db, "db"},
+};
+
+void Writer::header(std::string& out) const {
+  if (format != Format::Csv && format != Format::Tsv) return;
+  bool first = true;
+  for (const auto& f : kFieldNames) {
+    if (!(fields & f.field)) continue;
+    if (!first) out.push_back(format == Format::Csv ? ',' : '\t');
+    first = false;
+    out += f.name;
+  }
+  out.push_back('\n');
+}
+
+const char* Writer::content_type() const {
+  switch (format) {
+    case Format::Text:   return "text/plain; charset=utf-8";
+    case Format::Json:   return "application/json";
+    case Format::Ndjson: return "application/x-ndjson";
+    case Format::Csv:    return "text/csv; charset=utf-8";
+    case Format::Tsv:    return "text/tab-separated-values; charset=utf-8";
+    case Format::Binary: return "application/octet-stream";
+  }
+  return "application/octet-stream";
+}
+
+bool parse_format(std::string_view name, Format& out) {
+  static const struct {
+    const char* name;
+    Format format;
+  } kFormats[] = {
+    {"text", Format::Text}, {"json", Format::Json}, {"ndjson", Format::Ndjson},
+    {"csv", Format::Csv},   {"tsv", Format::Tsv},   {"binary", Format::Binary},
+  };
+  for (const auto& f : kFormats) {
+    if (name == f.name) {
+      out = f.format;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parse_fields(std::string_view list, unsigned& out) {
+  unsigned fields = 0;
+  while (!list.empty()) {
+    const size_t comma = list.find(',');
+    const std::string_view name = list.substr(0, comma);
+    bool known = false;
+    if (name == "all") {
+      fields |= AllFields;
+      known = true;
+    }
+    for (const auto& f : kFieldNames) {
+      if (name == f.name) {
+        fields |= f.field;
+        known = true;
+      }
+    }
+    if (!known) return false;
+    list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+  }
+  if (fields == 0) return false;
+  out = fields;
+  return true;
+}
+
+} // namespace oui::fmt
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace oui {
+
+class CompiledDB;
+struct ImageEntry;
+struct LookupResult;
+
+namespace fmt {
+
+// Output formats shared by the CLI (lookup, join) and the HTTP API.
+enum class Format { Text, Json, Ndjson, Csv, Tsv, Binary };
+
+enum Field : unsigned {
+  Input = 1u << 0,    // the query as given
+  Found = 1u << 1,
+  Prefix = 1u << 2,   // matched prefix, e.g. 00:1B:C5:00:00
+  MaskBits = 1u << 3,
+  Vendor = 1u << 4,
+  Comment = 1u << 5,
+  Db = 1u << 6,       // DB path (HTTP API)
+  AllFields = (1u << 7) - 1,
+};
+
+// Field presets; writers for these are specialised at compile time, any
+// other combination goes through a writer that tests fields at run time.
+constexpr unsigned kDefaultFields = Found | Prefix | MaskBits | Vendor | Comment;
+constexpr unsigned kApiFields = kDefaultFields | Db;
+constexpr unsigned kJoinFields = Prefix | MaskBits | Vendor;
+constexpr unsigned kBulkFields = Input | kDefaultFields;
+
+// One lookup answer. Strings are views; nothing is copied until written.
+struct Record {
+  std::string_view input;
+  bool found = false;
+  uint64_t prefix = 0;
+  int maskBits = 0;
+  std::string_view vendor;
+  std::string_view comment;
+  std::string_view db;
+};
+
+Record from_image(const CompiledDB& db, const ImageEntry* hit, std::string_view input);
+Record from_result(const LookupResult& r, std::string_view input);
+
+// Records are appended to a caller-owned buffer so bulk callers can reuse it.
+//  text    "Vendor: ..." lines (or "No match") per record
+//  json    one object, no trailing newline; ndjson adds '\n'
+//  csv     RFC 4180 quoting; tsv replaces tabs/newlines in values by spaces
+//  binary  little-endian: u8 found, u8 mask bits, 48-bit prefix (6 bytes,
+//          least significant first, so 00:1B:C5 is 00 00 00 C5 1B 00), then
+//          u16 length + bytes for each selected string field
+//          (input, vendor, comment, db in that order)
+// Misses write only the input and found fields (plus empty columns in
+// csv/tsv so rows stay aligned).
+struct Writer {
+  Format format;
+  unsigned fields;
+  void (*write)(const Record& r, unsigned fields, std::string& out);
+
+  void operator()(const Record& r, std::string& out) const { write(r, fields, out); }
+  // Column names for csv/tsv; nothing for the other formats.
+  void header(std::string& out) const;
+  const char* content_type() const;
+};
+
+Writer writer(Format format, unsigned fields);
+
+bool parse_format(std::string_view name, Format& out);
+// Comma-separated field names (input,found,prefix,mask_bits,vendor,comment,db).
+bool parse_fields(std::string_view list, unsigned& out);
+
+} // namespace fmt
+} // namespace oui
@@ -1,65 +1,80 @@
 #include "oui/mac.h"
-#include <cctype>
-#include <sstream>
 
 namespace oui {
 
-std::optional<MacParse> parse_mac_or_prefix(const std::string& input) {
-  std::string hex;
-  hex.reserve(input.size());
-  for (char ch : input) {
-    if (std::isxdigit(static_cast<unsigned char>(ch))) {
-      hex.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
-    }
-  }
-
-  if (hex.size() % 2 != 0) return std::nullopt;
-  if (hex.size() == 0) return std::nullopt;
-  if (hex.size() > 12) return std::nullopt;
-
-  int bitsHint = static_cast<int>(hex.size() / 2) * 8;
-
+std::optional<MacParse> parse_mac_or_prefix(std::string_view input) {
   auto hexval = [](char c)->int {
     if (c >= '0' && c <= '9') return c - '0';
-    return 10 + (c - 'a');
+    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
+    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
+    return -1;
   };
 
+  // non-hex characters are separators and are skipped
   uint64_t v = 0;
-  for (size_t i = 0; i < hex.size(); i += 2) {
-    int byte = (hexval(hex[i]) << 4) | hexval(hex[i + 1]);
-    v = (v << 8) | static_cast<uint8_t>(byte);
+  int digits = 0;
+  for (char ch : input) {
+    int h = hexval(ch);
+    if (h < 0) continue;
+    if (++digits > 12) return std::nullopt;
+    v = (v << 4) | static_cast<uint64_t>(h);
   }
 
+  if (digits % 2 != 0) return std::nullopt;
+  if (digits == 0) return std::nullopt;
+
+  int bitsHint = (digits / 2) * 8;
+
   // left-align to 48-bit
-  int shift = (12 - static_cast<int>(hex.size())) * 4;
-  v <<= shift;
+  v <<= (12 - digits) * 4;
 
   return MacParse{v, bitsHint};
 }
 
+std::optional<MacParse> parse_prefix(std::string_view input) {
+  const size_t slash = input.find('/');
+  if (slash == std::string_view::npos) return parse_mac_or_prefix(input);
+
+  auto mp = parse_mac_or_prefix(input.substr(0, slash));
+  std::string_view len = input.substr(slash + 1);
+  if (!mp || len.empty() || len.size() > 2) return std::nullopt;
+  int bits = 0;
+  for (char c : len) {
+    if (c < '0' || c > '9') return std::nullopt;
+    bits = bits * 10 + (c - '0');
+  }
+  if (bits > 48) return std::nullopt;
+  mp->mac48 &= mask48(bits);
+  mp->bitsHint = bits;
+  return mp;
+}
+
 uint64_t mask48(int bits) {
   if (bits <= 0) return 0;
   if (bits >= 48) return 0xFFFFFFFFFFFFULL;
   return (0xFFFFFFFFFFFFULL << (48 - bits)) & 0xFFFFFFFFFFFFULL;
 }
 
-std::string prefix_to_string(uint64_t prefix48, int maskBits) {
+void append_prefix(std::string& out, uint64_t prefix48, int maskBits) {
+  static const char kHex[] = "0123456789ABCDEF";
   uint64_t p = prefix48 & mask48(maskBits);
 
   int bytes = (maskBits + 7) / 8;
   if (bytes < 1) bytes = 1;
   if (bytes > 6) bytes = 6;
 
-  std::ostringstream oss;
   for (int i = 0; i < bytes; i++) {
     uint8_t b = (p >> (8 * (5 - i))) & 0xFF;
-    if (i) oss << ":";
-    oss << std::hex << std::uppercase;
-    oss.width(2);
-    oss.fill('0');
-    oss << (int)b;
+    if (i) out.push_back(':');
+    out.push_back(kHex[b >> 4]);
+    out.push_back(kHex[b & 0xF]);
   }
-  return oss.str();
+}
+
+std::string prefix_to_string(uint64_t prefix48, int maskBits) {
+  std::string out;
+  append_prefix(out, prefix48, maskBits);
+  return out;
 }
 
 } // namespace oui
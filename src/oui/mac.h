@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace oui {
 
@@ -10,9 +11,14 @@ struct MacParse {
   int bitsHint = 0;     // inferred bits from input length (e.g., 24 for OUI)
 };
 
-std::optional<MacParse> parse_mac_or_prefix(const std::string& input);
+std::optional<MacParse> parse_mac_or_prefix(std::string_view input);
+// Like parse_mac_or_prefix, but also accepts "prefix/bits" (e.g. 00:1B:C5:00:00/36);
+// bitsHint is the explicit length and mac48 is masked to it.
+std::optional<MacParse> parse_prefix(std::string_view input);
 uint64_t mask48(int bits);
 std::string prefix_to_string(uint64_t prefix48, int maskBits);
+// Appends the prefix_to_string() form without a temporary.
+void append_prefix(std::string& out, uint64_t prefix48, int maskBits);
 
 } // namespace oui
 
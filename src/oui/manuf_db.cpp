@@ -1,10 +1,14 @@
 #include "oui/manuf_db.h"
+#include "oui/compiled_db.h"
 #include "oui/mac.h"
-#include "util/str.h"
 
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string_view>
 #include <vector>
 #include <sys/stat.h>
 
@@ -12,51 +16,142 @@
 
 namespace oui {
 
-static bool parse_line(const std::string& raw, Entry& out) {
-  std::string line = util::str::trim(raw);
-  if (line.empty() || line[0] == '#') return false;
+static std::string_view trim_view(std::string_view s) {
+  size_t b = s.find_first_not_of(" \t\r\n");
+  if (b == std::string_view::npos) return {};
+  size_t e = s.find_last_not_of(" \t\r\n");
+  return s.substr(b, e - b + 1);
+}
 
-  std::string comment;
+static bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+LineParse parse_line(std::string_view raw, Entry& out, bool& hostBits) {
+  std::string_view line = trim_view(raw);
+  if (line.empty() || line[0] == '#') return LineParse::Skip;
+
+  std::string_view comment;
   auto posHash = line.find('#');
-  if (posHash != std::string::npos) {
-    comment = util::str::trim(line.substr(posHash + 1));
-    line = util::str::trim(line.substr(0, posHash));
+  if (posHash != std::string_view::npos) {
+    comment = trim_view(line.substr(posHash + 1));
+    line = trim_view(line.substr(0, posHash));
   }
-  if (line.empty()) return false;
+  if (line.empty()) return LineParse::Skip;
 
-  std::istringstream iss(line);
-  std::string prefixToken;
-  if (!(iss >> prefixToken)) return false;
+  size_t tokEnd = 0;
+  while (tokEnd < line.size() && !is_space(line[tokEnd])) tokEnd++;
+  std::string_view prefixToken = line.substr(0, tokEnd);
 
-  std::string vendor;
-  std::getline(iss, vendor);
-  vendor = util::str::trim(vendor);
-  if (vendor.empty()) return false;
+  std::string_view vendor = trim_view(line.substr(tokEnd));
+  if (vendor.empty()) return LineParse::Malformed;
 
   int maskBits = -1;
   auto slash = prefixToken.find('/');
-  if (slash != std::string::npos) {
-    try {
-      maskBits = std::stoi(prefixToken.substr(slash + 1));
-    } catch (...) {
-      return false;
-    }
+  if (slash != std::string_view::npos) {
+    std::string_view bits = prefixToken.substr(slash + 1);
+    if (!bits.empty() && bits[0] == '+') bits.remove_prefix(1);
+    auto [ptr, ec] = std::from_chars(bits.data(), bits.data() + bits.size(), maskBits);
+    if (ec != std::errc()) return LineParse::Malformed;
     prefixToken = prefixToken.substr(0, slash);
   }
 
   auto mp = parse_mac_or_prefix(prefixToken);
-  if (!mp) return false;
+  if (!mp) return LineParse::Malformed;
 
   if (maskBits < 0) maskBits = mp->bitsHint;
-  if (maskBits < 0 || maskBits > 48) return false;
+  if (maskBits < 0 || maskBits > 48) return LineParse::Malformed;
 
+  hostBits = (mp->mac48 & ~mask48(maskBits) & 0xFFFFFFFFFFFFULL) != 0;
   out.prefix = mp->mac48 & mask48(maskBits);
   out.maskBits = maskBits;
-  out.vendor = vendor;
-  out.comment = comment;
-  return true;
+  out.vendor.assign(vendor.data(), vendor.size());
+  out.comment.assign(comment.data(), comment.size());
+  return LineParse::Ok;
+}
+
+using Index = std::unordered_map<int, std::unordered_map<uint64_t, Entry>>;
+
+static std::string issue_text(std::string_view line) {
+  line = trim_view(line);
+  return std::string(line.substr(0, 200));
 }
 
+// Splits a stream of blocks into lines without copying, except for the one
+// line that straddles two blocks.
+class LineSink {
+public:
+  LineSink(Index& index, std::vector<Overwrite>& overwrites,
+           std::vector<LineIssue>& malformed, std::vector<LineIssue>& hostBits)
+    : index_(index), overwrites_(overwrites), malformed_(malformed), hostBits_(hostBits) {}
+
+  size_t count() const { return count_; }
+
+  void feed(const char* data, size_t n) {
+    std::string_view block(data, n);
+    size_t start = 0;
+    while (true) {
+      size_t nl = block.find('\n', start);
+      if (nl == std::string_view::npos) break;
+      if (!carry_.empty()) {
+        carry_.append(block.data() + start, nl - start);
+        line(carry_);
+        carry_.clear();
+      } else {
+        line(block.substr(start, nl - start));
+      }
+      start = nl + 1;
+    }
+    carry_.append(block.data() + start, block.size() - start);
+  }
+
+  void finish() {
+    if (!carry_.empty()) line(carry_);
+    carry_.clear();
+  }
+
+private:
+  Index& index_;
+  std::vector<Overwrite>& overwrites_;
+  std::vector<LineIssue>& malformed_;
+  std::vector<LineIssue>& hostBits_;
+  size_t count_ = 0;
+  size_t lineNo_ = 0;
+  std::string carry_;
+  Entry scratch_;
+  std::unordered_map<uint64_t, size_t> lineOf_; // (mask << 48 | prefix) -> line
+
+  void line(std::string_view l) {
+    lineNo_++;
+    bool hostBits = false;
+    switch (parse_line(l, scratch_, hostBits)) {
+      case LineParse::Skip:
+        return;
+      case LineParse::Malformed:
+        malformed_.push_back({lineNo_, issue_text(l)});
+        return;
+      case LineParse::Ok:
+        break;
+    }
+    if (hostBits) hostBits_.push_back({lineNo_, issue_text(l)});
+
+    size_t& defined = lineOf_[(uint64_t(scratch_.maskBits) << 48) | scratch_.prefix];
+    Entry& slot = index_[scratch_.maskBits][scratch_.prefix];
+    if (defined != 0) {
+      // later lines overwrite earlier duplicates; keep a record for explain/check
+      overwrites_.push_back({scratch_.prefix, scratch_.maskBits, lineNo_, defined,
+                             slot.vendor, scratch_.vendor});
+    }
+    defined = lineNo_;
+    slot = std::move(scratch_);
+    scratch_ = Entry{};
+    count_++;
+  }
+};
+
+static const size_t kReadBlock = 256 * 1024;
+static const size_t kInflateBlock = 1024 * 1024;
+
 static bool has_gzip_magic(const std::string& path) {
   std::ifstream in(path, std::ios::binary);
   if (!in) return false;
@@ -83,54 +178,86 @@ static bool starts_with(const std::string& value, const std::string& prefix) {
   return value.size() >= prefix.size() && value.compare(0, prefix.size(), prefix) == 0;
 }
 
-static LoadResult load_from_gzip(const std::string& path,
-                                 std::unordered_map<int, std::unordered_map<uint64_t, Entry>>& index,
-                                 size_t& outCount) {
-  gzFile gz = gzopen(path.c_str(), "rb");
-  if (!gz) {
-    return {false, "Cannot open gzip file: " + path, 0};
+static LoadResult load_from_plain(const std::string& path, LineSink& sink) {
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    return {false, "Cannot open file: " + path, 0};
   }
 
-  std::string line;
-  std::vector<char> buffer(4096);
+  std::vector<char> buf(kReadBlock);
+  size_t n;
+  while ((n = std::fread(buf.data(), 1, buf.size(), f)) > 0) sink.feed(buf.data(), n);
+  bool failed = std::ferror(f) != 0;
+  std::fclose(f);
+  if (failed) return {false, "read error: " + path, 0};
+
+  sink.finish();
+  return {true, "ok", sink.count()};
+}
 
-  while (true) {
-    char* res = gzgets(gz, buffer.data(), static_cast<int>(buffer.size()));
-    if (!res) break;
+// Raw inflate in large blocks; handles concatenated gzip members.
+static LoadResult load_from_gzip(const std::string& path, LineSink& sink) {
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    return {false, "Cannot open gzip file: " + path, 0};
+  }
 
-    line.append(res);
-    if (!line.empty() && line.back() == '\n') {
-      Entry e;
-      if (parse_line(line, e)) {
-        index[e.maskBits][e.prefix] = e;
-        outCount++;
+  z_stream zs{};
+  if (inflateInit2(&zs, 15 + 32) != Z_OK) { // +32: detect gzip/zlib header
+    std::fclose(f);
+    return {false, "inflateInit failed", 0};
+  }
+
+  std::vector<unsigned char> in(kReadBlock);
+  std::vector<char> out(kInflateBlock);
+  std::string error;
+  bool ended = false;
+  bool fresh = false; // just reset after a member; trailing junk is ignored
+
+  while (error.empty()) {
+    if (zs.avail_in == 0) {
+      size_t n = std::fread(in.data(), 1, in.size(), f);
+      if (n == 0) {
+        if (std::ferror(f)) error = "read error";
+        else if (!ended) error = "unexpected end of gzip stream";
+        break;
       }
-      line.clear();
+      zs.next_in = in.data();
+      zs.avail_in = static_cast<uInt>(n);
+    }
+    if (ended) {
+      inflateReset(&zs);
+      ended = false;
+      fresh = true;
     }
-  }
 
-  if (!line.empty()) {
-    Entry e;
-    if (parse_line(line, e)) {
-      index[e.maskBits][e.prefix] = e;
-      outCount++;
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    int rc = inflate(&zs, Z_NO_FLUSH);
+    if (rc == Z_DATA_ERROR && fresh) {
+      ended = true;
+      break;
+    }
+    fresh = false;
+    if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+      error = zs.msg ? zs.msg : "inflate error";
+      break;
     }
+    sink.feed(out.data(), out.size() - zs.avail_out);
+    if (rc == Z_STREAM_END) ended = true;
   }
 
-  int errnum = Z_OK;
-  const char* err = gzerror(gz, &errnum);
-  gzclose(gz);
-  if (errnum != Z_OK && errnum != Z_STREAM_END) {
-    return {false, std::string("gzip read error: ") + (err ? err : "unknown"), 0};
+  inflateEnd(&zs);
+  std::fclose(f);
+  if (!error.empty()) {
+    return {false, "gzip read error: " + error, 0};
   }
 
-  return {true, "ok", outCount};
+  sink.finish();
+  return {true, "ok", sink.count()};
 }
 
-LoadResult ManufDB::load(const std::string& path) {
-  index_.clear();
-  masks_desc_.clear();
-
+std::string resolve_db_path(const std::string& path) {
   std::vector<std::string> candidates;
   candidates.reserve(4);
   auto add_candidates = [&](const std::string& base) {
@@ -148,48 +275,84 @@ LoadResult ManufDB::load(const std::string& path) {
     add_candidates("../" + path);
   }
 
-  std::string resolved;
   for (const auto& candidate : candidates) {
-    if (file_exists(candidate)) {
-      resolved = candidate;
-      break;
-    }
+    if (file_exists(candidate)) return candidate;
   }
+  return "";
+}
+
+LoadResult ManufDB::load(const std::string& path) {
+  index_.clear();
+  masks_desc_.clear();
+  overwrites_.clear();
+  malformed_.clear();
+  hostBits_.clear();
+  image_.reset();
+
+  std::string resolved = resolve_db_path(path);
   if (resolved.empty()) {
     return {false, "Cannot open file: " + path, 0};
   }
 
-  size_t count = 0;
-  if (has_gzip_magic(resolved)) {
-    auto result = load_from_gzip(resolved, index_, count);
-    if (!result.ok) return result;
-  } else {
-    std::ifstream in(resolved);
-    if (!in) {
-      return {false, "Cannot open file: " + resolved, 0};
-    }
-
-    std::string line;
-    while (std::getline(in, line)) {
-      Entry e;
-      if (!parse_line(line, e)) continue;
-      index_[e.maskBits][e.prefix] = e; // 마지막이 덮어쓰지만 보통 문제 없음
-      count++;
-    }
-  }
+  LineSink sink(index_, overwrites_, malformed_, hostBits_);
+  auto result = has_gzip_magic(resolved) ? load_from_gzip(resolved, sink)
+                                         : load_from_plain(resolved, sink);
+  if (!result.ok) return result;
+  const size_t count = sink.count();
 
   masks_desc_.reserve(index_.size());
   for (auto& kv : index_) masks_desc_.push_back(kv.first);
   std::sort(masks_desc_.begin(), masks_desc_.end(), std::greater<int>());
 
+  std::vector<const Entry*> all;
+  all.reserve(count);
+  for (const auto& kv : index_) {
+    for (const auto& pe : kv.second) all.push_back(&pe.second);
+  }
+  image_ = CompiledDB::from_buffer(CompiledDB::serialize(all));
+  if (!image_) return {false, "Failed to compile DB", 0};
+
   return {true, "ok", count};
 }
 
+bool ManufDB::attach(std::shared_ptr<const CompiledDB> image) {
+  if (!image) return false;
+  index_.clear();
+  masks_desc_.clear();
+  overwrites_.clear();
+  malformed_.clear();
+  hostBits_.clear();
+  image_ = std::move(image);
+  return true;
+}
+
+bool ManufDB::relocate(std::shared_ptr<const CompiledDB> image) {
+  if (!image || !image_ || image->size() != image_->size() ||
+      std::memcmp(image->data(), image_->data(), image->size()) != 0) {
+    return false;
+  }
+  index_.clear();
+  masks_desc_.clear();
+  image_ = std::move(image);
+  return true;
+}
+
 LookupResult ManufDB::lookup(const std::string& macOrPrefix) const {
   auto mp = parse_mac_or_prefix(macOrPrefix);
   if (!mp) return {false, {}, ""};
+  return lookup(mp->mac48);
+}
 
-  const uint64_t mac = mp->mac48;
+LookupResult ManufDB::lookup(uint64_t mac) const {
+  if (index_.empty() && image_) {
+    const ImageEntry* hit = image_->find(mac);
+    if (!hit) return {false, {}, ""};
+    LookupResult r;
+    r.found = true;
+    r.entry = image_->to_entry(*hit);
+    r.best_prefix = prefix_to_string(hit->prefix, hit->maskBits);
+    return r;
+  }
 
   // 최장 매칭: mask 큰 것부터 확인
   for (int bits : masks_desc_) {
@@ -210,4 +373,134 @@ LookupResult ManufDB::lookup(const std::string& macOrPrefix) const {
   return {false, {}, ""};
 }
 
+RangeResult ManufDB::lookup_all(const std::string& prefix, size_t offset, size_t limit) const {
+  auto mp = parse_prefix(prefix);
+  if (!mp) return {};
+  return lookup_all(mp->mac48, mp->bitsHint, offset, limit);
+}
+
+RangeResult ManufDB::lookup_all(uint64_t prefix, int bits, size_t offset, size_t limit) const {
+  RangeResult out;
+  out.parsed = true;
+  out.maskBits = bits;
+  out.prefix = prefix & mask48(bits);
+  out.offset = offset;
+  if (!image_) return out;
+
+  // Covering entries: at most one per shorter mask. Covered ones: a
+  // contiguous run of each longer mask, since groups are sorted by prefix.
+  using Run = std::pair<const ImageEntry*, const ImageEntry*>;
+  std::vector<Run> runs;
+  const uint64_t hi = out.prefix | (~mask48(bits) & 0xFFFFFFFFFFFFULL);
+  for (uint32_t i = 0; i < image_->mask_count(); i++) {
+    const int mb = image_->masks()[i].bits;
+    Run r{nullptr, nullptr};
+    if (mb <= bits) {
+      if (const ImageEntry* e = image_->find_at(i, out.prefix & mask48(mb))) r = {e, e + 1};
+    } else {
+      r = image_->range_at(i, out.prefix, hi);
+    }
+    if (r.first == r.second) continue;
+    out.total += static_cast<size_t>(r.second - r.first);
+    runs.push_back(r);
+  }
+
+  // Merge the per-mask runs, skipping to the requested page.
+  size_t skipped = 0;
+  while (out.entries.size() < limit) {
+    Run* best = nullptr;
+    for (Run& r : runs) {
+      if (r.first == r.second) continue;
+      if (!best || r.first->prefix < best->first->prefix ||
+          (r.first->prefix == best->first->prefix && r.first->maskBits < best->first->maskBits)) {
+        best = &r;
+      }
+    }
+    if (!best) break;
+    if (skipped < offset) {
+      skipped++;
+    } else {
+      out.entries.push_back(image_->to_entry(*best->first));
+    }
+    ++best->first;
+  }
+  return out;
+}
+
+static uint64_t nanos_between(std::chrono::steady_clock::time_point a,
+                              std::chrono::steady_clock::time_point b) {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+}
+
+Explain ManufDB::explain(const std::string& macOrPrefix) const {
+  using Clock = std::chrono::steady_clock;
+  Explain ex;
+  const auto start = Clock::now();
+  auto mp = parse_mac_or_prefix(macOrPrefix);
+  auto t = Clock::now();
+  ex.parseNanos = nanos_between(start, t);
+  if (!mp) {
+    ex.totalNanos = ex.parseNanos;
+    return ex;
+  }
+  ex.parsed = true;
+  ex.mac48 = mp->mac48;
+  ex.inputBits = mp->bitsHint;
+
+  auto record = [&](int bits, uint64_t key, const std::string* vendor) {
+    auto now = Clock::now();
+    ProbeStep step;
+    step.maskBits = bits;
+    step.key = key;
+    step.hit = vendor != nullptr;
+    step.shadowed = step.hit && ex.result.found;
+    if (vendor) step.vendor = *vendor;
+    step.nanos = nanos_between(t, now);
+    t = now;
+    ex.steps.push_back(std::move(step));
+  };
+
+  if (index_.empty() && image_) {
+    for (uint32_t i = 0; i < image_->mask_count(); i++) {
+      const int bits = image_->masks()[i].bits;
+      const uint64_t key = ex.mac48 & mask48(bits);
+      const ImageEntry* e = image_->find_at(i, key);
+      std::string vendor = e ? std::string(image_->vendor(e->vendorId)) : "";
+      record(bits, key, e ? &vendor : nullptr);
+      if (e && !ex.result.found) {
+        ex.result.found = true;
+        ex.result.entry = image_->to_entry(*e);
+        ex.result.best_prefix = prefix_to_string(e->prefix, e->maskBits);
+      }
+    }
+  } else {
+    for (int bits : masks_desc_) {
+      const uint64_t key = ex.mac48 & mask48(bits);
+      const Entry* e = nullptr;
+      auto itMask = index_.find(bits);
+      if (itMask != index_.end()) {
+        auto it = itMask->second.find(key);
+        if (it != itMask->second.end()) e = &it->second;
+      }
+      record(bits, key, e ? &e->vendor : nullptr);
+      if (e && !ex.result.found) {
+        ex.result.found = true;
+        ex.result.entry = *e;
+        ex.result.best_prefix = prefix_to_string(e->prefix, e->maskBits);
+      }
+    }
+  }
+  ex.totalNanos = nanos_between(start, Clock::now());
+
+  for (const auto& ow : overwrites_) {
+    for (const auto& step : ex.steps) {
+      if (ow.maskBits == step.maskBits && ow.prefix == step.key) {
+        ex.overwrites.push_back(ow);
+        break;
+      }
+    }
+  }
+  return ex;
+}
+
 } // namespace oui
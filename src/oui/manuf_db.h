@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -25,15 +27,104 @@ struct LookupResult {
   std::string best_prefix; // human-readable prefix string
 };
 
+// One page of lookup_all(); entries are ordered by (prefix, maskBits).
+struct RangeResult {
+  bool parsed = false;
+  uint64_t prefix = 0;
+  int maskBits = 0;
+  size_t total = 0;           // matches before paging
+  size_t offset = 0;
+  std::vector<Entry> entries; // at most limit entries starting at offset
+};
+
+// A (prefix, mask) defined on more than one line; the later line wins.
+struct Overwrite {
+  uint64_t prefix = 0;
+  int maskBits = 0;
+  size_t line = 0;          // 1-based line of the winning definition
+  size_t previousLine = 0;  // line that was dropped
+  std::string previousVendor;
+  std::string vendor;
+};
+
+struct LineIssue {
+  size_t line = 0; // 1-based
+  std::string text;
+};
+
+struct ProbeStep {
+  int maskBits = 0;
+  uint64_t key = 0;
+  bool hit = false;
+  bool shadowed = false; // hit, but a longer mask already matched
+  std::string vendor;
+  uint64_t nanos = 0;
+};
+
+struct Explain {
+  bool parsed = false;
+  uint64_t mac48 = 0;
+  int inputBits = 0;
+  uint64_t parseNanos = 0;
+  uint64_t totalNanos = 0;
+  LookupResult result;
+  std::vector<ProbeStep> steps;         // every mask, longest first
+  std::vector<Overwrite> overwrites;    // load-time drops on the probed keys
+};
+
+class CompiledDB;
+
+enum class LineParse { Skip, Ok, Malformed };
+
+// One manuf line (blank and comment lines are Skip). hostBits reports a
+// prefix with bits set beyond its mask; they are dropped from out.prefix.
+LineParse parse_line(std::string_view raw, Entry& out, bool& hostBits);
+
+// Resolves a --db argument to an existing file (tries .gz / plain and ../data/).
+// Returns an empty string when nothing exists.
+std::string resolve_db_path(const std::string& path);
+
+// Const members may be called from any number of threads at once; load(),
+// attach() and relocate() must not overlap with anything else. To swap in a new DB while
+// other threads keep reading, publish it through oui::DbHandle.
 class ManufDB {
 public:
   LoadResult load(const std::string& path);
+  // Serve lookups from an already compiled image (e.g. a shared segment).
+  bool attach(std::shared_ptr<const CompiledDB> image);
+  // Serve lookups from image, a copy of compiled() placed elsewhere (see
+  // oui/placement.h). Unlike attach() the load findings are kept. False if
+  // the contents differ.
+  bool relocate(std::shared_ptr<const CompiledDB> image);
+
   LookupResult lookup(const std::string& macOrPrefix) const;
+  LookupResult lookup(uint64_t mac48) const;
+  // Every entry covering prefix/bits (shorter or equal masks) or covered by
+  // it (longer masks). One binary search per mask plus contiguous scans.
+  RangeResult lookup_all(uint64_t prefix, int bits, size_t offset = 0,
+                         size_t limit = SIZE_MAX) const;
+  // Accepts anything parse_prefix() does; bits default to the input length.
+  RangeResult lookup_all(const std::string& prefix, size_t offset = 0,
+                         size_t limit = SIZE_MAX) const;
+  // Probes every mask (no early exit) and times each step.
+  Explain explain(const std::string& macOrPrefix) const;
+
+  // Findings of the last load(); all empty after attach().
+  const std::vector<Overwrite>& overwrites() const { return overwrites_; }
+  const std::vector<LineIssue>& malformed() const { return malformed_; }
+  const std::vector<LineIssue>& host_bits() const { return hostBits_; }
+
+  // Sorted flat image of the current contents; null before load/attach.
+  std::shared_ptr<const CompiledDB> compiled() const { return image_; }
 
 private:
   // maskBits -> (prefix -> entry)
   std::unordered_map<int, std::unordered_map<uint64_t, Entry>> index_;
   std::vector<int> masks_desc_; // existing masks, sorted desc
+  std::vector<Overwrite> overwrites_;
+  std::vector<LineIssue> malformed_;
+  std::vector<LineIssue> hostBits_;
+  std::shared_ptr<const CompiledDB> image_;
 };
 
 } // namespace oui
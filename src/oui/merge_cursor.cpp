@@ -0,0 +1,43 @@
+#include "oui/merge_cursor.h"
+#include "oui/mac.h"
+
+#include <algorithm>
+
+namespace oui {
+
+MergeCursor::MergeCursor(const CompiledDB& db) : db_(db) {
+  for (uint32_t i = 0; i < db.mask_count(); i++) {
+    const ImageMask& m = db.masks()[i];
+    pos_.push_back(db.entries() + m.first);
+    end_.push_back(db.entries() + m.first + m.count);
+  }
+}
+
+// First entry in [pos, end) with prefix >= key. Gallops so sparse input
+// skips ahead in O(log gap) instead of walking every entry.
+static const ImageEntry* advance(const ImageEntry* pos, const ImageEntry* end, uint64_t key) {
+  if (pos == end || pos->prefix >= key) return pos;
+  size_t step = 1;
+  const size_t left = static_cast<size_t>(end - pos);
+  while (step < left && pos[step].prefix < key) step *= 2;
+  return std::lower_bound(pos + step / 2, pos + std::min(step, left), key,
+    [](const ImageEntry& e, uint64_t k) { return e.prefix < k; });
+}
+
+const ImageEntry* MergeCursor::find(uint64_t mac48) {
+  if (sorted_ && mac48 < last_) sorted_ = false;
+  if (!sorted_) return db_.find(mac48);
+  last_ = mac48;
+  count_++;
+
+  // Masks are longest first, so the first hit is the longest match. Shorter
+  // groups left behind catch up on a later key.
+  for (size_t i = 0; i < pos_.size(); i++) {
+    const uint64_t key = mac48 & mask48(db_.masks()[i].bits);
+    pos_[i] = advance(pos_[i], end_[i], key);
+    if (pos_[i] != end_[i] && pos_[i]->prefix == key) return pos_[i];
+  }
+  return nullptr;
+}
+
+} // namespace oui
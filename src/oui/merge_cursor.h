@@ -0,0 +1,34 @@
+#pragma once
+#include "oui/compiled_db.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace oui {
+
+// Longest-prefix matching for a stream of ascending MACs. Keeps one
+// forward-only position per mask group of the image, so a sorted stream is a
+// single pass over the entries: no hashing and no per-record binary search.
+// A key smaller than the previous one switches the cursor to
+// CompiledDB::find() for the rest of the stream.
+class MergeCursor {
+public:
+  explicit MergeCursor(const CompiledDB& db);
+
+  // Same result as db.find(mac48).
+  const ImageEntry* find(uint64_t mac48);
+
+  bool sorted() const { return sorted_; }
+  // Records seen before the first out-of-order key.
+  uint64_t sorted_count() const { return count_; }
+
+private:
+  const CompiledDB& db_;
+  std::vector<const ImageEntry*> pos_;
+  std::vector<const ImageEntry*> end_;
+  uint64_t last_ = 0;
+  uint64_t count_ = 0;
+  bool sorted_ = true;
+};
+
+} // namespace oui
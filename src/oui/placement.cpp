@@ -0,0 +1,156 @@
+#include "oui/placement.h"
+#include "oui/compiled_db.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace oui {
+
+static constexpr size_t kHugePageSize = size_t(2) << 20;
+static constexpr int kMpolBind = 2;          // MPOL_BIND
+static constexpr unsigned kMpolMoveFlag = 2; // MPOL_MF_MOVE
+
+static size_t round_up(size_t n, size_t to) {
+  return (n + to - 1) / to * to;
+}
+
+static std::string errno_text() {
+  return std::strerror(errno);
+}
+
+// 2 MB aligned anonymous mapping, so THP can back it from the first byte.
+static void* map_aligned(size_t len) {
+  const size_t span = len + kHugePageSize;
+  void* raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) return MAP_FAILED;
+  const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  const uintptr_t aligned = round_up(start, kHugePageSize);
+  if (aligned > start) ::munmap(raw, aligned - start);
+  const uintptr_t end = aligned + len;
+  if (start + span > end) ::munmap(reinterpret_cast<void*>(end), start + span - end);
+  return reinterpret_cast<void*>(aligned);
+}
+
+PlacedImage place(const CompiledDB& src, const Placement& p) {
+  PlacedImage out;
+  const size_t size = src.size();
+  const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  HugePages huge = p.huge;
+  size_t len = 0;
+  void* mem = MAP_FAILED;
+
+  if (huge == HugePages::Explicit) {
+    len = round_up(size, kHugePageSize);
+    mem = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                 -1, 0);
+    if (mem == MAP_FAILED) {
+      out.warnings.push_back("explicit huge pages unavailable (" + errno_text() +
+                             "; reserve some with vm.nr_hugepages), using transparent huge pages");
+      huge = HugePages::Transparent;
+    }
+  }
+  if (mem == MAP_FAILED) {
+    if (huge == HugePages::Transparent) {
+      len = round_up(size, kHugePageSize);
+      mem = map_aligned(len);
+      if (mem != MAP_FAILED && ::madvise(mem, len, MADV_HUGEPAGE) != 0) {
+        out.warnings.push_back("transparent huge pages unavailable: " + errno_text());
+      }
+    } else {
+      len = round_up(size, page);
+      mem = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+  }
+  if (mem == MAP_FAILED) {
+    out.message = "mmap failed: " + errno_text();
+    return out;
+  }
+
+  // Bind before the copy touches the pages so they are allocated on the node.
+  if (p.node >= 0) {
+    constexpr size_t kMaxNodes = 1024;
+    unsigned long mask[kMaxNodes / (8 * sizeof(unsigned long))] = {};
+    const size_t bitsPerWord = 8 * sizeof(unsigned long);
+    if (static_cast<size_t>(p.node) < kMaxNodes) {
+      mask[p.node / bitsPerWord] |= 1UL << (p.node % bitsPerWord);
+    }
+    if (::syscall(SYS_mbind, mem, len, kMpolBind, mask, kMaxNodes + 1, kMpolMoveFlag) != 0) {
+      out.warnings.push_back("mbind to node " + std::to_string(p.node) + " failed: " + errno_text());
+    }
+  }
+
+  std::memcpy(mem, src.data(), size);
+  // The copy faulted in [0, size); fault the padding too so nothing is left.
+  auto* bytes = static_cast<volatile char*>(mem);
+  for (size_t off = round_up(size, page); off < len; off += page) bytes[off] = 0;
+
+  if (p.lock && ::mlock(mem, len) != 0) {
+    out.warnings.push_back("mlock failed: " + errno_text() + " (raise RLIMIT_MEMLOCK)");
+  }
+  ::mprotect(mem, len, PROT_READ);
+
+  std::shared_ptr<const void> keep(mem, [len](const void* m) { ::munmap(const_cast<void*>(m), len); });
+  out.image = CompiledDB::from_memory(mem, size, keep);
+  if (!out.image) {
+    out.message = "placed image failed validation";
+    return out;
+  }
+  out.ok = true;
+  out.message = "ok";
+  return out;
+}
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+static std::vector<int> parse_list(const std::string& s) {
+  std::vector<int> out;
+  const char* p = s.c_str();
+  while (*p) {
+    char* end = nullptr;
+    const long lo = std::strtol(p, &end, 10);
+    if (end == p) break;
+    long hi = lo;
+    p = end;
+    if (*p == '-') {
+      hi = std::strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long i = lo; i <= hi; i++) out.push_back(static_cast<int>(i));
+    if (*p == ',') p++;
+    else break;
+  }
+  return out;
+}
+
+static std::string read_line(const std::string& path) {
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line);
+  return line;
+}
+
+std::vector<NumaNode> numa_nodes() {
+  std::vector<NumaNode> nodes;
+  for (int id : parse_list(read_line("/sys/devices/system/node/online"))) {
+    NumaNode n;
+    n.id = id;
+    n.cpus = parse_list(read_line("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist"));
+    if (!n.cpus.empty()) nodes.push_back(std::move(n));
+  }
+  if (nodes.empty()) {
+    NumaNode all;
+    const unsigned n = std::thread::hardware_concurrency();
+    for (unsigned i = 0; i < n; i++) all.cpus.push_back(static_cast<int>(i));
+    nodes.push_back(std::move(all));
+  }
+  return nodes;
+}
+
+} // namespace oui
@@ -0,0 +1,45 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace oui {
+
+class CompiledDB;
+
+enum class HugePages {
+  Off,
+  Transparent, // 2 MB aligned mapping with MADV_HUGEPAGE
+  Explicit,    // MAP_HUGETLB from the reserved pool (vm.nr_hugepages)
+};
+
+// How place() lays out a private copy of a compiled image.
+struct Placement {
+  HugePages huge = HugePages::Off;
+  bool lock = false; // mlock; needs RLIMIT_MEMLOCK headroom or CAP_IPC_LOCK
+  int node = -1;     // NUMA node the pages are bound to; -1 leaves it to first touch
+};
+
+struct PlacedImage {
+  bool ok = false;
+  std::string message;
+  std::shared_ptr<const CompiledDB> image; // read-only, fully populated
+  // Requests that could not be honoured (no huge pages reserved, mlock
+  // limit, ...); the copy is still usable.
+  std::vector<std::string> warnings;
+};
+
+// Copies src into a fresh anonymous mapping placed as asked. Every page is
+// faulted in before returning, so lookups never take a first-touch fault.
+PlacedImage place(const CompiledDB& src, const Placement& p);
+
+struct NumaNode {
+  int id = 0;
+  std::vector<int> cpus;
+};
+
+// Online NUMA nodes that have CPUs, from sysfs. A single node holding every
+// CPU when the machine is not NUMA (or sysfs is missing).
+std::vector<NumaNode> numa_nodes();
+
+} // namespace oui
@@ -0,0 +1,166 @@
+#include "oui/shm_cache.h"
+#include "oui/compiled_db.h"
+#include "util/str.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace oui::shm {
+
+static const char kShmMagic[8] = {'O', 'U', 'I', 'S', 'H', 'M', '1', '\0'};
+
+struct SegmentHeader {
+  char magic[8];
+  std::atomic<uint32_t> ready; // set last, after the image is fully written
+  int32_t ownerPid;
+  SourceStamp stamp;
+  uint64_t imageSize;
+};
+
+// Image starts on a cache line so its own alignment requirements hold.
+static const size_t kImageOffset = (sizeof(SegmentHeader) + 63) & ~size_t(63);
+
+// Per user as well as per file: another user's segment is never trusted
+// (see map_readonly), so each user keeps a cache of their own.
+static std::string segment_name(const std::string& path) {
+  char buf[PATH_MAX];
+  std::string key = ::realpath(path.c_str(), buf) ? std::string(buf) : path;
+  return "/oui-" + std::to_string(::geteuid()) + "-" + util::str::hex64(util::str::fnv1a64(key.data(), key.size()));
+}
+
+std::optional<SourceStamp> stamp_of(const std::string& path) {
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0) return std::nullopt;
+  SourceStamp s;
+  s.dev = static_cast<uint64_t>(st.st_dev);
+  s.ino = static_cast<uint64_t>(st.st_ino);
+  s.size = static_cast<uint64_t>(st.st_size);
+  s.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+  return s;
+}
+
+enum class SegmentState { Missing, Current, Stale, Busy };
+
+static SegmentState inspect(const SegmentHeader* h, size_t mapped, const SourceStamp& stamp) {
+  if (mapped < kImageOffset || std::memcmp(h->magic, kShmMagic, sizeof(kShmMagic)) != 0) {
+    return SegmentState::Stale;
+  }
+  if (h->ready.load(std::memory_order_acquire) == 0) {
+    // Publisher still writing, or it died half way through.
+    if (::kill(h->ownerPid, 0) != 0 && errno == ESRCH) return SegmentState::Stale;
+    return SegmentState::Busy;
+  }
+  if (!(h->stamp == stamp)) return SegmentState::Stale;
+  if (kImageOffset + h->imageSize > mapped) return SegmentState::Stale;
+  // Published by a build with another image layout: same source, but this
+  // build cannot attach it, so it has to be replaced.
+  if (h->imageSize < sizeof(ImageHeader)) return SegmentState::Stale;
+  const auto* image = reinterpret_cast<const ImageHeader*>(reinterpret_cast<const char*>(h) + kImageOffset);
+  if (image->version != CompiledDB::kVersion) return SegmentState::Stale;
+  return SegmentState::Current;
+}
+
+struct Mapping {
+  void* base = nullptr;
+  size_t size = 0;
+};
+
+static Mapping map_readonly(const std::string& name) {
+  int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) return {};
+  struct stat st {};
+  Mapping m;
+  // The name is predictable and the stamp is readable by anyone who can stat
+  // the manuf file, so only a segment this user created, and that nobody
+  // else can write, is trusted.
+  if (::fstat(fd, &st) == 0 && st.st_size > 0 && st.st_uid == ::geteuid() &&
+      (st.st_mode & (S_IWGRP | S_IWOTH)) == 0) {
+    void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED) {
+      m.base = p;
+      m.size = static_cast<size_t>(st.st_size);
+    }
+  }
+  ::close(fd);
+  return m;
+}
+
+static SegmentState probe(const std::string& name, const SourceStamp& stamp) {
+  Mapping m = map_readonly(name);
+  if (!m.base) return SegmentState::Missing;
+  SegmentState s = inspect(static_cast<const SegmentHeader*>(m.base), m.size, stamp);
+  ::munmap(m.base, m.size);
+  return s;
+}
+
+std::shared_ptr<const CompiledDB> attach(const std::string& path, const SourceStamp& stamp) {
+  Mapping m = map_readonly(segment_name(path));
+  if (!m.base) return nullptr;
+
+  std::shared_ptr<const void> keep(m.base, [size = m.size](const void* p) {
+    ::munmap(const_cast<void*>(p), size);
+  });
+  const auto* h = static_cast<const SegmentHeader*>(m.base);
+  if (inspect(h, m.size, stamp) != SegmentState::Current) return nullptr;
+
+  const auto* image = static_cast<const uint8_t*>(m.base) + kImageOffset;
+  return CompiledDB::from_memory(image, h->imageSize, std::move(keep));
+}
+
+bool publish(const std::string& path, const SourceStamp& stamp, const CompiledDB& image) {
+  const std::string name = segment_name(path);
+  const size_t total = kImageOffset + image.size();
+
+  int fd = -1;
+  for (int attempt = 0; attempt < 2 && fd < 0; attempt++) {
+    fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd >= 0 || errno != EEXIST) break;
+    // Missing here means a segment map_readonly() does not trust; replace
+    // it like a stale one (the sticky /dev/shm keeps other users' segments).
+    const SegmentState s = probe(name, stamp);
+    if (s == SegmentState::Current || s == SegmentState::Busy) return false;
+    // Readers keep their existing mappings; new ones will see our segment.
+    ::shm_unlink(name.c_str());
+  }
+  if (fd < 0) return false;
+
+  if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    return false;
+  }
+  void* p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    ::shm_unlink(name.c_str());
+    return false;
+  }
+
+  auto* h = new (p) SegmentHeader();
+  std::memcpy(h->magic, kShmMagic, sizeof(kShmMagic));
+  h->ownerPid = static_cast<int32_t>(::getpid());
+  h->stamp = stamp;
+  h->imageSize = image.size();
+  std::memcpy(static_cast<uint8_t*>(p) + kImageOffset, image.data(), image.size());
+  h->ready.store(1, std::memory_order_release);
+
+  ::munmap(p, total);
+  return true;
+}
+
+bool remove(const std::string& path) {
+  return ::shm_unlink(segment_name(path).c_str()) == 0;
+}
+
+} // namespace oui::shm
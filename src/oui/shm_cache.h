@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace oui { class CompiledDB; }
+
+// Daemonless cache of compiled DB images in POSIX shared memory. The first
+// process publishes its image under a name derived from the user and the DB
+// path; later processes of the same user map it read-only instead of parsing
+// the file again.
+namespace oui::shm {
+
+struct SourceStamp {
+  uint64_t dev = 0;
+  uint64_t ino = 0;
+  uint64_t size = 0;
+  int64_t mtimeNs = 0;
+
+  bool operator==(const SourceStamp& o) const {
+    return dev == o.dev && ino == o.ino && size == o.size && mtimeNs == o.mtimeNs;
+  }
+};
+
+std::optional<SourceStamp> stamp_of(const std::string& path);
+
+// Maps the published image for path if it matches stamp; null otherwise.
+std::shared_ptr<const CompiledDB> attach(const std::string& path, const SourceStamp& stamp);
+
+// Publishes image for path, replacing a stale or abandoned segment.
+// Returns false if another process owns a current segment or shm is unavailable.
+bool publish(const std::string& path, const SourceStamp& stamp, const CompiledDB& image);
+
+// Unlinks the segment for path (call while path still exists). Mappings
+// already attached stay valid.
+bool remove(const std::string& path);
+
+} // namespace oui::shm
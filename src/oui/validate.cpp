@@ -0,0 +1,96 @@
+#include "oui/validate.h"
+#include "oui/compiled_db.h"
+#include "oui/mac.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_set>
+
+namespace oui {
+
+// Tolerate a little noise in upstream files, but not a broken download.
+static const size_t kMaxMalformedPerMille = 10;
+
+bool CheckReport::fatal(std::string& why) const {
+  if (entries == 0) {
+    why = "no entries";
+    return true;
+  }
+  if (malformed.size() * 1000 > entries * kMaxMalformedPerMille) {
+    why = std::to_string(malformed.size()) + " malformed lines";
+    return true;
+  }
+  return false;
+}
+
+// Nested entries for image entries [begin, end).
+static std::vector<Nested> find_nested(const CompiledDB& img, uint32_t begin, uint32_t end) {
+  std::vector<Nested> out;
+  const ImageMask* masks = img.masks();
+  const ImageEntry* entries = img.entries();
+  for (uint32_t i = begin; i < end; i++) {
+    const ImageEntry& e = entries[i];
+    for (uint32_t m = 0; m < img.mask_count(); m++) {
+      if (masks[m].bits >= e.maskBits) continue;
+      const ImageEntry* outer = img.find_at(m, e.prefix & mask48(masks[m].bits));
+      if (!outer) continue;
+      out.push_back({e.prefix, e.maskBits, std::string(img.vendor(e.vendorId)),
+                     outer->prefix, outer->maskBits, std::string(img.vendor(outer->vendorId))});
+      break; // report the closest enclosing entry only
+    }
+  }
+  return out;
+}
+
+CheckReport check(const ManufDB& db, unsigned threads) {
+  const auto start = std::chrono::steady_clock::now();
+  CheckReport r;
+  r.malformed = db.malformed();
+  r.hostBits = db.host_bits();
+  for (const auto& ow : db.overwrites()) {
+    (ow.vendor == ow.previousVendor ? r.duplicates : r.conflicts).push_back(ow);
+  }
+
+  auto img = db.compiled();
+  if (!img) return r;
+  r.entries = img->entry_count();
+
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  const uint32_t n = img->entry_count();
+  const uint32_t chunk = std::max<uint32_t>(4096, (n + threads - 1) / threads);
+  std::vector<std::vector<Nested>> parts((n + chunk - 1) / chunk);
+  std::vector<std::thread> workers;
+  for (size_t p = 0; p < parts.size(); p++) {
+    const uint32_t b = static_cast<uint32_t>(p) * chunk;
+    const uint32_t e = std::min(n, b + chunk);
+    if (p + 1 == parts.size()) {
+      parts[p] = find_nested(*img, b, e); // last chunk on the calling thread
+    } else {
+      workers.emplace_back([&, p, b, e] { parts[p] = find_nested(*img, b, e); });
+    }
+  }
+  for (auto& w : workers) w.join();
+  for (auto& part : parts) {
+    r.nested.insert(r.nested.end(), std::make_move_iterator(part.begin()),
+                    std::make_move_iterator(part.end()));
+  }
+
+  for (uint32_t m = 0; m < img->mask_count(); m++) {
+    const ImageMask& mask = img->masks()[m];
+    MaskStats& st = r.masks[mask.bits];
+    st.entries = mask.count;
+    std::unordered_set<uint32_t> vendors;
+    for (uint32_t i = mask.first; i < mask.first + mask.count; i++) {
+      vendors.insert(img->entries()[i].vendorId);
+    }
+    st.vendors = vendors.size();
+  }
+  for (const auto& nd : r.nested) r.masks[nd.maskBits].nested++;
+
+  r.nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count());
+  return r;
+}
+
+} // namespace oui
@@ -0,0 +1,47 @@
+#pragma once
+#include "oui/manuf_db.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace oui {
+
+// An entry lying inside a shorter-mask entry. Normal for MA-M/MA-S blocks
+// carved out of an MA-L, but worth seeing when vendors disagree.
+struct Nested {
+  uint64_t prefix = 0;
+  int maskBits = 0;
+  std::string vendor;
+  uint64_t outerPrefix = 0;
+  int outerMaskBits = 0;
+  std::string outerVendor;
+};
+
+struct MaskStats {
+  size_t entries = 0;
+  size_t vendors = 0;     // distinct vendor strings at this mask
+  size_t nested = 0;      // entries inside a shorter-mask entry
+};
+
+struct CheckReport {
+  size_t entries = 0;
+  std::vector<LineIssue> malformed;
+  std::vector<LineIssue> hostBits;
+  std::vector<Overwrite> duplicates; // same prefix/mask, same vendor
+  std::vector<Overwrite> conflicts;  // same prefix/mask, different vendor
+  std::vector<Nested> nested;
+  std::map<int, MaskStats> masks;    // by mask bits
+  uint64_t nanos = 0;
+
+  // Hard failures that should stop an update from being installed.
+  bool fatal(std::string& why) const;
+};
+
+// Runs over the sorted compiled image with up to `threads` workers
+// (0 = hardware concurrency). Line-level findings come from db's last load().
+CheckReport check(const ManufDB& db, unsigned threads = 0);
+
+} // namespace oui
@@ -0,0 +1,170 @@
+#include "update/background.h"
+#include "oui/compiled_db.h"
+#include "oui/db_handle.h"
+#include "oui/manuf_db.h"
+#include "oui/validate.h"
+#include "util/fs.h"
+#include "util/str.h"
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+
+namespace update {
+
+static int64_t unix_now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string content_tag(const oui::ManufDB& db) {
+  auto image = db.compiled();
+  if (!image) return "";
+  return util::str::hex64(util::str::fnv1a64(image->data(), image->size()));
+}
+
+BackgroundUpdater::BackgroundUpdater(oui::DbHandle& handle, BackgroundOptions opt)
+  : handle_(handle), opt_(std::move(opt)) {
+  handle_.reader().with([&](const oui::ManufDB& db, uint64_t version) {
+    currentTag_ = content_tag(db);
+    status_.version = version;
+    if (auto image = db.compiled()) status_.entries = image->entry_count();
+  });
+  // The DB on disk is as old as its file, not as the process.
+  struct stat st{};
+  status_.loadedAt = ::stat(opt_.dbPath.c_str(), &st) == 0 ? st.st_mtime : unix_now();
+}
+
+BackgroundUpdater::~BackgroundUpdater() {
+  stop();
+}
+
+void BackgroundUpdater::start() {
+  if (thread_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = false;
+  }
+  thread_ = std::thread([this] { loop(); });
+}
+
+void BackgroundUpdater::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+void BackgroundUpdater::loop() {
+  // Lowest priority for this thread only (Linux nice is per thread), so the
+  // parse, check and compile take CPU the request workers leave idle.
+  ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), 19);
+  std::mt19937_64 rng(std::random_device{}());
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    int64_t wait = opt_.intervalSec;
+    if (opt_.jitterSec > 0) {
+      wait += static_cast<int64_t>(rng() % (2 * uint64_t(opt_.jitterSec) + 1)) - opt_.jitterSec;
+    }
+    if (cv_.wait_for(lock, std::chrono::seconds(std::max<int64_t>(1, wait)), [&] { return stop_; })) return;
+    lock.unlock();
+    const uint64_t before = handle_.version();
+    UpdateResult r = run_once();
+    if (!r.ok) std::cerr << "update failed, keeping version " << before << ": " << r.message << "\n";
+    else if (handle_.version() != before) std::cerr << "update: " << r.message << "\n";
+    lock.lock();
+  }
+}
+
+UpdateResult BackgroundUpdater::fail(const std::string& why) {
+  std::lock_guard<std::mutex> lock(mu_);
+  status_.failures++;
+  status_.consecutiveFailures++;
+  status_.lastOk = false;
+  status_.lastMessage = why;
+  return {false, why, 0};
+}
+
+UpdateResult BackgroundUpdater::run_once() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    status_.checks++;
+    status_.lastCheck = unix_now();
+  }
+
+  // Fetched next to the DB so the final rename stays on one filesystem.
+  const std::string staging = opt_.dbPath + ".fetch";
+  DownloadOptions dl = opt_.download;
+  dl.validate = false; // checked below, on the very DB that gets published
+  // A stalled mirror must not hold this thread (and stop()) past the next check.
+  if (dl.timeoutSec <= 0 || dl.timeoutSec > opt_.intervalSec) dl.timeoutSec = std::max(1, opt_.intervalSec);
+  UpdateResult fetched = download_manuf(opt_.url, staging, dl);
+  if (!fetched.ok) return fail("fetch: " + fetched.message);
+
+  auto db = std::make_unique<oui::ManufDB>();
+  auto lr = db->load(staging);
+  if (!lr.ok) {
+    util::fs::remove_file(staging);
+    return fail("invalid DB: " + lr.message);
+  }
+  // One thread: the request workers keep the other cores.
+  auto report = oui::check(*db, 1);
+  std::string why;
+  if (report.fatal(why)) {
+    util::fs::remove_file(staging);
+    return fail("invalid DB: " + why);
+  }
+
+  const std::string tag = content_tag(*db);
+  if (tag == currentTag_) {
+    util::fs::remove_file(staging);
+    std::lock_guard<std::mutex> lock(mu_);
+    status_.lastSuccess = unix_now();
+    status_.consecutiveFailures = 0;
+    status_.lastOk = true;
+    status_.lastMessage = "unchanged";
+    return {true, "unchanged", fetched.bytes};
+  }
+
+  if (prepare_ && !prepare_(*db, why)) {
+    util::fs::remove_file(staging);
+    return fail("prepare: " + why);
+  }
+  // Persist first: a restart must come back with what is being served.
+  if (!util::fs::atomic_replace(staging, opt_.dbPath)) {
+    util::fs::remove_file(staging);
+    return fail("cannot replace " + opt_.dbPath);
+  }
+
+  const uint64_t version = handle_.publish(std::move(db));
+  currentTag_ = tag;
+  if (onPublish_) onPublish_(version, tag);
+
+  const std::string msg = "version " + std::to_string(version) + ", " + std::to_string(report.entries) +
+                          " entries, " + std::to_string(report.malformed.size()) + " malformed";
+  std::lock_guard<std::mutex> lock(mu_);
+  status_.version = version;
+  status_.entries = report.entries;
+  status_.loadedAt = status_.lastSuccess = unix_now();
+  status_.swaps++;
+  status_.consecutiveFailures = 0;
+  status_.lastOk = true;
+  status_.lastMessage = msg;
+  return {true, msg, fetched.bytes};
+}
+
+BackgroundStatus BackgroundUpdater::status() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return status_;
+}
+
+} // namespace update
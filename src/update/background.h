@@ -0,0 +1,93 @@
+#pragma once
+#include "update/updater.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace oui {
+class DbHandle;
+class ManufDB;
+} // namespace oui
+
+namespace update {
+
+struct BackgroundOptions {
+  std::string url;         // anything download_manuf() takes, including file://
+  std::string dbPath;      // a new DB replaces this file before it is swapped in
+  int intervalSec = 86400;
+  int jitterSec = 0;       // each wait is intervalSec +- up to jitterSec
+  DownloadOptions download;
+};
+
+// Snapshot of a BackgroundUpdater for /metrics. Times are unix seconds, 0
+// for never.
+struct BackgroundStatus {
+  uint64_t version = 0;        // DB version being served
+  size_t entries = 0;
+  int64_t loadedAt = 0;        // when that version was swapped in (or startup)
+  int64_t lastCheck = 0;
+  int64_t lastSuccess = 0;     // last check that found a usable DB, changed or not
+  uint64_t checks = 0;
+  uint64_t swaps = 0;
+  uint64_t failures = 0;
+  uint64_t consecutiveFailures = 0;
+  bool lastOk = true;
+  std::string lastMessage;
+};
+
+// Keeps a served DB current without a restart. A thread of its own wakes up
+// every interval (with jitter, so a fleet does not hit the mirror at once),
+// fetches the URL, loads and checks the result, and publishes it to the
+// DbHandle; request threads only ever see complete versions. Any failure
+// keeps the current version and retries at the next wake-up.
+class BackgroundUpdater {
+public:
+  // Runs on the updater thread before a new DB is published (e.g. to place
+  // its image in huge pages). Returning false rejects the DB with err.
+  using Prepare = std::function<bool(oui::ManufDB& db, std::string& err)>;
+  // Runs after a publish with the new version and its content tag (hex
+  // FNV-1a of the compiled image, as used for ETags).
+  using Published = std::function<void(uint64_t version, const std::string& tag)>;
+
+  BackgroundUpdater(oui::DbHandle& handle, BackgroundOptions opt);
+  ~BackgroundUpdater();
+
+  BackgroundUpdater(const BackgroundUpdater&) = delete;
+  BackgroundUpdater& operator=(const BackgroundUpdater&) = delete;
+
+  void set_prepare(Prepare fn) { prepare_ = std::move(fn); }
+  void set_on_publish(Published fn) { onPublish_ = std::move(fn); }
+
+  void start();
+  void stop();
+  // One fetch-check-swap cycle on the calling thread. ok is true when the
+  // DB was swapped or is already up to date.
+  UpdateResult run_once();
+
+  BackgroundStatus status() const;
+
+private:
+  oui::DbHandle& handle_;
+  BackgroundOptions opt_;
+  Prepare prepare_;
+  Published onPublish_;
+  std::string currentTag_; // updater thread only
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  BackgroundStatus status_;
+  std::thread thread_;
+
+  void loop();
+  UpdateResult fail(const std::string& why);
+};
+
+// Content tag of db's compiled image; empty if it has none.
+std::string content_tag(const oui::ManufDB& db);
+
+} // namespace update
@@ -1,6 +1,10 @@
 #include "update/updater.h"
+#include "oui/manuf_db.h"
+#include "oui/validate.h"
 #include "util/fs.h"
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
 #include <sstream>
 #include <vector>
 
@@ -8,28 +12,48 @@ namespace update {
 
 struct Attempt {
   std::string name;
-  std::string cmd;
+  std::string cmd;    // shell command; empty for a local copy
+  std::string source; // file:// path
 };
 
+static const char kFileScheme[] = "file://";
+
+static bool copy_file(const std::string& from, const std::string& to) {
+  std::ifstream in(from, std::ios::binary);
+  std::ofstream out(to, std::ios::binary | std::ios::trunc);
+  if (!in || !out) return false;
+  out << in.rdbuf();
+  out.close();
+  return !in.bad() && out.good();
+}
+
 static void add_attempt(std::vector<Attempt>& attempts,
                         Downloader d,
                         const std::string& url,
-                        const std::string& tmpPath) {
+                        const std::string& tmpPath,
+                        int timeoutSec) {
   if (d == Downloader::Curl) {
     std::ostringstream cmd;
-    cmd << "curl -L -f -sS "
+    cmd << "curl -L -f -sS ";
+    if (timeoutSec > 0) {
+      cmd << "--connect-timeout " << std::min(timeoutSec, 30) << " --max-time " << timeoutSec << " ";
+    }
+    cmd
         << "-o " << util::fs::shell_escape(tmpPath) << " "
         << util::fs::shell_escape(url);
-    attempts.push_back({"curl", cmd.str()});
+    attempts.push_back({"curl", cmd.str(), ""});
     return;
   }
 
   if (d == Downloader::Wget) {
     std::ostringstream cmd;
-    cmd << "wget -q "
+    cmd << "wget -q ";
+    // -T bounds each connect and read; one try instead of wget's 20.
+    if (timeoutSec > 0) cmd << "-T " << timeoutSec << " -t 1 ";
+    cmd
         << "-O " << util::fs::shell_escape(tmpPath) << " "
         << util::fs::shell_escape(url);
-    attempts.push_back({"wget", cmd.str()});
+    attempts.push_back({"wget", cmd.str(), ""});
     return;
   }
 
@@ -37,26 +61,51 @@ static void add_attempt(std::vector<Attempt>& attempts,
     std::ostringstream cmd;
     cmd << "python3 -c "
         << util::fs::shell_escape(
-             "import sys, urllib.request; "
+             "import signal, socket, sys, urllib.request; "
+             "t = int(sys.argv[3]); "
+             "t and (socket.setdefaulttimeout(t), signal.alarm(t)); "
              "urllib.request.urlretrieve(sys.argv[1], sys.argv[2])"
            )
         << " " << util::fs::shell_escape(url)
-        << " " << util::fs::shell_escape(tmpPath);
-    attempts.push_back({"python3", cmd.str()});
+        << " " << util::fs::shell_escape(tmpPath)
+        << " " << timeoutSec;
+    attempts.push_back({"python3", cmd.str(), ""});
     return;
   }
 }
 
+// Loads the downloaded file and rejects it if the check finds it unusable.
+static bool validate_download(const std::string& tmpPath, std::string& outSummary) {
+  oui::ManufDB db;
+  auto lr = db.load(tmpPath);
+  if (!lr.ok) {
+    outSummary = "invalid DB: " + lr.message;
+    return false;
+  }
+  auto report = oui::check(db);
+  std::string why;
+  if (report.fatal(why)) {
+    outSummary = "invalid DB: " + why;
+    return false;
+  }
+  outSummary = std::to_string(report.entries) + " entries, " +
+               std::to_string(report.malformed.size()) + " malformed, " +
+               std::to_string(report.conflicts.size()) + " conflicts";
+  return true;
+}
+
 static bool run_download_attempts(const std::vector<Attempt>& attempts,
                                   const std::string& tmpPath,
                                   const std::string& outPath,
+                                  bool validate,
                                   size_t& outBytes,
-                                  std::string& outUsedTool) {
+                                  std::string& outUsedTool,
+                                  std::string& outSummary) {
   for (const auto& a : attempts) {
     util::fs::remove_file(tmpPath);
 
-    int rc = std::system(a.cmd.c_str());
-    if (rc != 0) continue;
+    const bool fetched = a.cmd.empty() ? copy_file(a.source, tmpPath) : std::system(a.cmd.c_str()) == 0;
+    if (!fetched) continue;
 
     size_t sz = util::fs::file_size(tmpPath);
     if (sz == 0) {
@@ -64,6 +113,11 @@ static bool run_download_attempts(const std::vector<Attempt>& attempts,
       continue;
     }
 
+    if (validate && !validate_download(tmpPath, outSummary)) {
+      util::fs::remove_file(tmpPath);
+      continue;
+    }
+
     if (!util::fs::atomic_replace(tmpPath, outPath)) {
       util::fs::remove_file(tmpPath);
       return false;
@@ -86,19 +140,28 @@ UpdateResult download_manuf(const std::string& url,
   std::vector<Attempt> attempts;
   attempts.reserve(opt.order.size());
 
-  for (auto d : opt.order) {
-    add_attempt(attempts, d, url, tmpPath);
+  // file:// is copied directly, so offline setups need no download tool.
+  if (url.rfind(kFileScheme, 0) == 0) {
+    attempts.push_back({"file", "", url.substr(sizeof(kFileScheme) - 1)});
+  } else {
+    for (auto d : opt.order) {
+      add_attempt(attempts, d, url, tmpPath, opt.timeoutSec);
+    }
   }
 
   size_t bytes = 0;
   std::string used;
+  std::string summary;
 
-  bool ok = run_download_attempts(attempts, tmpPath, outPath, bytes, used);
+  bool ok = run_download_attempts(attempts, tmpPath, outPath, opt.validate, bytes, used, summary);
   if (!ok) {
+    if (!summary.empty()) return {false, "all download methods failed (last: " + summary + ")", 0};
     return {false, "all download methods failed", 0};
   }
 
-  return {true, "ok (" + used + ")", bytes};
+  std::string msg = "ok (" + used + ")";
+  if (!summary.empty()) msg += "; " + summary;
+  return {true, msg, bytes};
 }
 
 } // namespace update
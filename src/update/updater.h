@@ -23,6 +23,11 @@ struct DownloadOptions {
     Downloader::Wget,
     Downloader::Python3
   };
+  // Parse and check the download (oui::check) before replacing the DB.
+  bool validate = true;
+  // Bound on one download, passed to the tool; a stalled mirror then counts
+  // as a failure instead of hanging the caller. 0 for no bound.
+  int timeoutSec = 300;
 };
 
 UpdateResult download_manuf(const std::string& url,
@@ -0,0 +1,25 @@
+#include "util/gzip.h"
+#include <zlib.h>
+
+namespace util::gzip {
+
+std::string compress(const std::string& data, int level) {
+  z_stream zs{};
+  // windowBits 15 + 16 selects the gzip wrapper instead of zlib's
+  if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return "";
+
+  std::string out;
+  out.resize(deflateBound(&zs, static_cast<uLong>(data.size())) + 32);
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  zs.avail_in = static_cast<uInt>(data.size());
+  zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+  zs.avail_out = static_cast<uInt>(out.size());
+
+  int rc = deflate(&zs, Z_FINISH);
+  deflateEnd(&zs);
+  if (rc != Z_STREAM_END) return "";
+  out.resize(zs.total_out);
+  return out;
+}
+
+} // namespace util::gzip
@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+
+namespace util::gzip {
+// gzip-framed deflate of data (RFC 1952). Returns empty on failure.
+std::string compress(const std::string& data, int level = 6);
+}
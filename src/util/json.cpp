@@ -41,8 +41,19 @@ static void dump(std::ostringstream& oss, const Value& val) {
     oss << (std::get<bool>(val.v) ? "true" : "false");
   } else if (std::holds_alternative<int>(val.v)) {
     oss << std::get<int>(val.v);
+  } else if (std::holds_alternative<int64_t>(val.v)) {
+    oss << std::get<int64_t>(val.v);
   } else if (std::holds_alternative<std::string>(val.v)) {
     oss << "\"" << esc(std::get<std::string>(val.v)) << "\"";
+  } else if (std::holds_alternative<Array>(val.v)) {
+    oss << "[";
+    bool first = true;
+    for (const auto& item : std::get<Array>(val.v)) {
+      if (!first) oss << ",";
+      first = false;
+      dump(oss, item);
+    }
+    oss << "]";
   } else {
     dump_obj(oss, std::get<Object>(val.v));
   }
@@ -1,24 +1,29 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 namespace util::json {
 
 struct Value;
 using Object = std::unordered_map<std::string, Value>;
+using Array = std::vector<Value>;
 
 struct Value {
-  using Var = std::variant<std::nullptr_t, bool, int, std::string, Object>;
+  using Var = std::variant<std::nullptr_t, bool, int, int64_t, std::string, Object, Array>;
   Var v;
 
   Value() : v(nullptr) {}
   Value(std::nullptr_t) : v(nullptr) {}
   Value(bool b) : v(b) {}
   Value(int i) : v(i) {}
+  Value(int64_t i) : v(i) {}
   Value(const std::string& s) : v(s) {}
   Value(const char* s) : v(std::string(s)) {}
   Value(const Object& o) : v(o) {}
+  Value(const Array& a) : v(a) {}
 };
 
 std::string stringify(const Object& obj);
@@ -1,8 +1,15 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace util::str {
 std::string trim(const std::string& s);
 std::string url_decode(const std::string& s);
+std::string to_lower(const std::string& s);
+
+// FNV-1a; stable across runs, used for cache keys and ETags
+uint64_t fnv1a64(const void* data, size_t n);
+std::string hex64(uint64_t v);
 }
 
@@ -0,0 +1,127 @@
+#include "web/executor.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace web {
+
+static int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Executor::~Executor() {
+  if (epfd_ >= 0) ::close(epfd_);
+}
+
+bool Executor::init() {
+  epfd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  return epfd_ >= 0;
+}
+
+void Executor::spawn(Task<> t) {
+  t.detach().resume();
+}
+
+Executor::Wait Executor::wait(int fd, uint32_t events, int timeoutMs) {
+  const int64_t deadline = timeoutMs > 0 ? now_ns() + int64_t(timeoutMs) * 1000000 : 0;
+  return Wait{this, fd, events, deadline, {}};
+}
+
+Executor::Wait Executor::readable(int fd, int timeoutMs) {
+  return wait(fd, EPOLLIN, timeoutMs);
+}
+
+Executor::Wait Executor::writable(int fd, int timeoutMs) {
+  return wait(fd, EPOLLOUT, timeoutMs);
+}
+
+bool Executor::Wait::await_suspend(std::coroutine_handle<> h) {
+  waiter = h;
+  // Could not register: resume at once with ready == false.
+  return ex->arm(*this);
+}
+
+// One-shot registrations: a fired or timed-out wait leaves the fd disarmed,
+// so a stale event can never reach a Wait that has gone away.
+bool Executor::arm(Wait& w) {
+  epoll_event ev{};
+  ev.events = w.events | EPOLLONESHOT;
+  ev.data.ptr = &w;
+  const size_t fd = static_cast<size_t>(w.fd);
+  if (fd >= registered_.size()) registered_.resize(fd + 1, 0);
+  const int op = registered_[fd] ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  if (::epoll_ctl(epfd_, op, w.fd, &ev) != 0) return false;
+  registered_[fd] = 1;
+  if (w.deadlineNs) link(w);
+  return true;
+}
+
+void Executor::link(Wait& w) {
+  // Timeouts are usually all the same length, so this stops at the tail.
+  Wait* after = tail_;
+  while (after && after->deadlineNs > w.deadlineNs) after = after->prev;
+  w.prev = after;
+  w.next = after ? after->next : head_;
+  if (w.next) w.next->prev = &w;
+  else tail_ = &w;
+  if (after) after->next = &w;
+  else head_ = &w;
+}
+
+void Executor::unlink(Wait& w) {
+  if (!w.deadlineNs) return;
+  if (w.prev) w.prev->next = w.next;
+  else head_ = w.next;
+  if (w.next) w.next->prev = w.prev;
+  else tail_ = w.prev;
+  w.prev = w.next = nullptr;
+}
+
+void Executor::close(int fd) {
+  if (static_cast<size_t>(fd) < registered_.size()) registered_[static_cast<size_t>(fd)] = 0;
+  ::close(fd);
+}
+
+int Executor::run() {
+  constexpr int kMaxEvents = 256;
+  epoll_event events[kMaxEvents];
+  while (true) {
+    int timeoutMs = -1;
+    if (head_) {
+      const int64_t left = head_->deadlineNs - now_ns();
+      timeoutMs = left > 0 ? static_cast<int>((left + 999999) / 1000000) : 0;
+    }
+    const int n = ::epoll_wait(epfd_, events, kMaxEvents, timeoutMs);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "epoll_wait failed: " << std::strerror(errno) << "\n";
+      return 1;
+    }
+    // Each fd shows up at most once per batch and only its own waiter can
+    // close it, so resuming one entry cannot invalidate another.
+    for (int i = 0; i < n; i++) {
+      Wait& w = *static_cast<Wait*>(events[i].data.ptr);
+      unlink(w);
+      w.ready = true;
+      w.waiter.resume();
+    }
+
+    const int64_t now = now_ns();
+    while (head_ && head_->deadlineNs <= now) {
+      Wait& w = *head_;
+      unlink(w);
+      ::epoll_ctl(epfd_, EPOLL_CTL_DEL, w.fd, nullptr);
+      registered_[static_cast<size_t>(w.fd)] = 0;
+      w.ready = false;
+      w.waiter.resume();
+    }
+  }
+}
+
+} // namespace web
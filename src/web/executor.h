@@ -0,0 +1,68 @@
+#pragma once
+#include "web/task.h"
+
+#include <coroutine>
+#include <cstdint>
+#include <vector>
+
+namespace web {
+
+// Single-threaded epoll event loop that drives coroutines. Each HttpServer
+// worker owns one, so there is one executor per core with --workers $(nproc).
+//
+// A coroutine does non-blocking syscalls itself and, on EAGAIN, suspends in
+// `co_await ex.readable(fd, ms)` / `writable(fd, ms)` until the fd is ready
+// or the timeout passes. Only one coroutine may wait on an fd at a time.
+class Executor {
+public:
+  Executor() = default;
+  ~Executor();
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  bool init();
+
+  // Starts t right away; it runs until its first suspension and is then
+  // resumed by run().
+  void spawn(Task<> t);
+
+  // Awaitable; resumes with true when the fd is ready, false on timeout.
+  // timeoutMs <= 0 waits forever.
+  struct Wait {
+    Executor* ex;
+    int fd;
+    uint32_t events;
+    int64_t deadlineNs;
+    std::coroutine_handle<> waiter;
+    bool ready = false;
+    Wait* prev = nullptr; // deadline list, earliest first
+    Wait* next = nullptr;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h);
+    bool await_resume() const noexcept { return ready; }
+  };
+
+  Wait readable(int fd, int timeoutMs);
+  Wait writable(int fd, int timeoutMs);
+
+  // Closes an fd that has been waited on (drops its registration).
+  void close(int fd);
+
+  // Runs until epoll fails; returns non-zero then.
+  int run();
+
+private:
+  int epfd_ = -1;
+  std::vector<uint8_t> registered_; // by fd
+  Wait* head_ = nullptr;
+  Wait* tail_ = nullptr;
+
+  Wait wait(int fd, uint32_t events, int timeoutMs);
+  bool arm(Wait& w);
+  void link(Wait& w);
+  void unlink(Wait& w);
+};
+
+} // namespace web
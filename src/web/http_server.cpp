@@ -1,16 +1,36 @@
 #include "web/http_server.h"
+#include "oui/compiled_db.h"
+#include "oui/db_handle.h"
+#include "oui/explain.h"
+#include "oui/format.h"
+#include "oui/mac.h"
 #include "oui/manuf_db.h"
+#include "update/background.h"
+#include "util/gzip.h"
 #include "util/str.h"
 #include "util/json.h"
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <sstream>
+#include <thread>
 
 namespace web {
 
@@ -70,18 +90,29 @@ async function go() {
 static const char* status_text(int status) {
   switch (status) {
     case 200: return "OK";
+    case 304: return "Not Modified";
     case 400: return "Bad Request";
     case 404: return "Not Found";
     case 405: return "Method Not Allowed";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 503: return "Service Unavailable";
     default: return "Error";
   }
 }
 
-static std::string http_response(int status, const std::string& contentType, const std::string& body) {
+// Bodies smaller than this are not worth the gzip framing overhead.
+static const size_t kMinGzipSize = 256;
+
+static std::string http_response(int status, const std::string& contentType, const std::string& body,
+                                 const std::string& extraHeaders = "") {
   std::ostringstream oss;
   oss << "HTTP/1.1 " << status << " " << status_text(status) << "\r\n";
-  oss << "Content-Type: " << contentType << "\r\n";
-  oss << "Content-Length: " << body.size() << "\r\n";
+  if (status != 304) {
+    oss << "Content-Type: " << contentType << "\r\n";
+    oss << "Content-Length: " << body.size() << "\r\n";
+  }
+  oss << extraHeaders;
   oss << "Connection: close\r\n";
   oss << "\r\n";
   oss << body;
@@ -106,10 +137,136 @@ static std::string get_query_param(const std::string& url, const std::string& ke
   return "";
 }
 
+// Value of a request header (name given in lower case), or "".
+static std::string get_header(const std::string& req, const std::string& name) {
+  std::istringstream iss(req);
+  std::string line;
+  std::getline(iss, line); // request line
+  while (std::getline(iss, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) break;
+    auto colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    if (util::str::to_lower(util::str::trim(line.substr(0, colon))) == name) {
+      return util::str::trim(line.substr(colon + 1));
+    }
+  }
+  return "";
+}
+
+static bool accepts_gzip(const std::string& acceptEncoding) {
+  std::istringstream iss(util::str::to_lower(acceptEncoding));
+  std::string part;
+  while (std::getline(iss, part, ',')) {
+    std::string coding = util::str::trim(part.substr(0, part.find(';')));
+    if (coding != "gzip" && coding != "*") continue;
+    auto q = part.find("q=");
+    if (q != std::string::npos && std::strtod(part.c_str() + q + 2, nullptr) <= 0.0) continue;
+    return true;
+  }
+  return false;
+}
+
+// If-None-Match uses weak comparison (RFC 7232 3.2).
+static bool etag_matches(const std::string& ifNoneMatch, const std::string& etag) {
+  if (ifNoneMatch.empty()) return false;
+  std::istringstream iss(ifNoneMatch);
+  std::string tag;
+  while (std::getline(iss, tag, ',')) {
+    tag = util::str::trim(tag);
+    if (tag == "*") return true;
+    if (tag.rfind("W/", 0) == 0) tag = tag.substr(2);
+    if (tag == etag) return true;
+  }
+  return false;
+}
+
+static std::string hash_tag(const std::string& s) {
+  return util::str::hex64(util::str::fnv1a64(s.data(), s.size()));
+}
+
 HttpServer::HttpServer(std::string host, int port, std::string dbPath, oui::ManufDB* db)
-  : host_(std::move(host)), port_(port), dbPath_(std::move(dbPath)), db_(db) {}
+  : listen_{{std::move(host), port}}, dbPath_(std::move(dbPath)), db_(db),
+    limiter_(new RateLimiter(0, 0)) {
+  if (db_) dbTag_ = update::content_tag(*db_);
+  indexTag_ = hash_tag(kIndexHtml);
+  indexGz_ = util::gzip::compress(kIndexHtml, 9);
+}
+
+HttpServer::HttpServer(std::string host, int port, std::string dbPath, oui::DbHandle* handle)
+  : HttpServer(std::move(host), port, std::move(dbPath), static_cast<oui::ManufDB*>(nullptr)) {
+  handle_ = handle;
+  handle_->reader().with([&](const oui::ManufDB& db, uint64_t version) {
+    dbTag_ = update::content_tag(db);
+    tags_.emplace_back(version, dbTag_);
+  });
+}
+
+void HttpServer::set_db_tag(uint64_t version, std::string tag) {
+  std::lock_guard<std::mutex> lock(tagMu_);
+  tags_.emplace_back(version, std::move(tag));
+  if (tags_.size() > 8) tags_.erase(tags_.begin());
+}
+
+const std::string& HttpServer::db_tag(uint64_t version) const {
+  struct Cached {
+    const HttpServer* owner = nullptr;
+    uint64_t version = 0;
+    std::string tag;
+  };
+  static thread_local Cached t_tag;
+  static const std::string kNone;
+  if (t_tag.owner == this && t_tag.version == version) return t_tag.tag;
+  std::lock_guard<std::mutex> lock(tagMu_);
+  for (auto it = tags_.rbegin(); it != tags_.rend(); ++it) {
+    if (it->first != version) continue;
+    t_tag = {this, version, it->second};
+    return t_tag.tag;
+  }
+  return kNone;
+}
+
+void HttpServer::set_limits(const ServerLimits& limits) {
+  limits_ = limits;
+  limiter_.reset(new RateLimiter(limits.ratePerSec, limits.burst));
+  if (limits_.ratePerSec > 0 && limits_.burst <= 0) limits_.burst = std::max(1.0, 2 * limits_.ratePerSec);
+}
+
+static bool is_index(const std::string& url) {
+  return url == "/" || url.rfind("/index.html", 0) == 0;
+}
+
+// Strong validator for cacheable GETs: the UI is static, API answers are a
+// pure function of the DB contents and the URL. Empty when not cacheable.
+std::string HttpServer::etag_for(const std::string& url, const std::string& dbTag) const {
+  if (is_index(url)) return "ui-" + indexTag_;
+  // explain output carries timings, so it is never byte-identical
+  if (get_query_param(url, "explain") == "1") return "";
+  if (url.rfind("/api/stats", 0) == 0) return "";
+  if (url.rfind("/api/", 0) == 0 && !dbTag.empty()) return dbTag + "-" + hash_tag(url);
+  return "";
+}
+
+// Set per worker thread by prepare_worker(): the worker's NUMA replica.
+static thread_local const oui::ManufDB* t_replica = nullptr;
+// The handle version pinned for the request being answered on this thread.
+static thread_local const oui::ManufDB* t_pinned = nullptr;
+// The worker's reader on handle_, set by serve_worker().
+static thread_local const HttpServer* t_readerOwner = nullptr;
+static thread_local oui::DbHandle::Reader* t_reader = nullptr;
+
+static void stamp(RequestTrace* trace, RequestTrace::Stage stage) {
+  if (trace) trace->stamp(stage);
+}
 
-std::string HttpServer::handle_request(const std::string& req, int& status, std::string& contentType) {
+void HttpServer::record_lookup(const std::string& mac, const oui::LookupResult& r) {
+  if (auto parsed = oui::parse_mac_or_prefix(mac)) {
+    stats_.record(parsed->mac48, r.found, r.entry.prefix, r.entry.maskBits, r.entry.vendor);
+  }
+}
+
+std::string HttpServer::handle_request(const std::string& req, int& status, std::string& contentType,
+                                       RequestTrace* trace) {
   // parse first line: METHOD URL HTTP/1.1
   std::istringstream iss(req);
   std::string method, url, ver;
@@ -127,12 +284,20 @@ std::string HttpServer::handle_request(const std::string& req, int& status, std:
     return "Method Not Allowed";
   }
 
-  if (url == "/" || url.rfind("/index.html", 0) == 0) {
+  if (is_index(url)) {
     status = 200;
     contentType = "text/html; charset=utf-8";
     return kIndexHtml;
   }
 
+  if (url == "/metrics") {
+    status = 200;
+    contentType = "text/plain; version=0.0.4";
+    std::string body = metrics_.render(limits_, limiter_->tracked());
+    if (updater_) body += render_update(updater_->status());
+    return body;
+  }
+
   if (url.rfind("/api/lookup", 0) == 0) {
     std::string mac = get_query_param(url, "mac");
     if (mac.empty()) {
@@ -141,19 +306,76 @@ std::string HttpServer::handle_request(const std::string& req, int& status, std:
       return R"({"found":false,"error":"missing mac param"})";
     }
 
-    auto r = db_->lookup(mac);
-    util::json::Object obj;
-    obj["found"] = util::json::Value(r.found);
-    if (r.found) {
-      obj["vendor"] = util::json::Value(r.entry.vendor);
-      obj["prefix"] = util::json::Value(r.best_prefix);
-      obj["mask_bits"] = util::json::Value(r.entry.maskBits);
-      obj["comment"] = util::json::Value(r.entry.comment);
-      obj["db"] = util::json::Value(dbPath_);
+    if (get_query_param(url, "all") == "1") {
+      const std::string off = get_query_param(url, "offset");
+      const std::string lim = get_query_param(url, "limit");
+      long offset = off.empty() ? 0 : std::strtol(off.c_str(), nullptr, 10);
+      long limit = lim.empty() ? 100 : std::strtol(lim.c_str(), nullptr, 10);
+      offset = std::max(0L, offset);
+      limit = std::max(1L, std::min(limit, 1000L));
+      auto rr = db().lookup_all(mac, static_cast<size_t>(offset), static_cast<size_t>(limit));
+      stamp(trace, RequestTrace::Lookup);
+      status = rr.parsed ? 200 : 400;
+      contentType = "application/json";
+      return util::json::stringify(oui::range_to_json(rr));
     }
+
+    auto r = db().lookup(mac);
+    stamp(trace, RequestTrace::Lookup);
+    record_lookup(mac, r);
+    if (get_query_param(url, "explain") == "1") {
+      util::json::Object obj;
+      obj["found"] = util::json::Value(r.found);
+      if (r.found) {
+        obj["vendor"] = util::json::Value(r.entry.vendor);
+        obj["prefix"] = util::json::Value(r.best_prefix);
+        obj["mask_bits"] = util::json::Value(r.entry.maskBits);
+        obj["comment"] = util::json::Value(r.entry.comment);
+        obj["db"] = util::json::Value(dbPath_);
+      }
+      obj["explain"] = util::json::Value(oui::explain_to_json(db().explain(mac)));
+      status = 200;
+      contentType = "application/json";
+      return util::json::stringify(obj);
+    }
+
+    oui::fmt::Format format = oui::fmt::Format::Json;
+    unsigned fields = oui::fmt::kApiFields;
+    const std::string f = get_query_param(url, "format");
+    const std::string fl = get_query_param(url, "fields");
+    if ((!f.empty() && !oui::fmt::parse_format(f, format)) ||
+        (!fl.empty() && !oui::fmt::parse_fields(fl, fields))) {
+      status = 400;
+      contentType = "application/json";
+      return R"({"found":false,"error":"bad format or fields param"})";
+    }
+    const oui::fmt::Writer write = oui::fmt::writer(format, fields);
+    oui::fmt::Record rec = oui::fmt::from_result(r, mac);
+    rec.db = dbPath_;
+    std::string body;
+    write.header(body);
+    write(rec, body);
+    status = 200;
+    contentType = write.content_type();
+    return body;
+  }
+
+  if (url.rfind("/debug/slow", 0) == 0) {
+    const std::string n = get_query_param(url, "n");
+    long limit = n.empty() ? 100 : std::strtol(n.c_str(), nullptr, 10);
+    limit = std::max(1L, std::min<long>(limit, FlightRecorder::kRecent));
     status = 200;
     contentType = "application/json";
-    return util::json::stringify(obj);
+    return util::json::stringify(trace_.to_json(static_cast<size_t>(limit)));
+  }
+
+  if (url.rfind("/api/stats/top", 0) == 0) {
+    const std::string n = get_query_param(url, "n");
+    long limit = n.empty() ? 10 : std::strtol(n.c_str(), nullptr, 10);
+    limit = std::max(1L, std::min<long>(limit, LookupStats::kCandidates));
+    status = 200;
+    contentType = "application/json";
+    return util::json::stringify(stats_.to_json(static_cast<size_t>(limit)));
   }
 
   status = 404;
@@ -161,63 +383,400 @@ std::string HttpServer::handle_request(const std::string& req, int& status, std:
   return "Not Found";
 }
 
-int HttpServer::serve_forever() {
-  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+std::string HttpServer::respond(const std::string& req, RequestTrace* trace) {
+  if (!handle_ || t_replica) return respond_db(req, dbTag_, trace);
+  struct PinScope {
+    explicit PinScope(const oui::ManufDB& d) { t_pinned = &d; }
+    ~PinScope() { t_pinned = nullptr; }
+  };
+  std::optional<oui::DbHandle::Reader> own; // callers outside a worker (fuzz targets)
+  oui::DbHandle::Reader* reader = t_readerOwner == this ? t_reader : &own.emplace(handle_->reader());
+  return reader->with([&](const oui::ManufDB& d, uint64_t version) {
+    PinScope pin(d);
+    return respond_db(req, db_tag(version), trace);
+  });
+}
+
+std::string HttpServer::respond_db(const std::string& req, const std::string& dbTag, RequestTrace* trace) {
+  std::istringstream iss(req);
+  std::string method, url;
+  iss >> method >> url;
+
+  const bool gzip = accepts_gzip(get_header(req, "accept-encoding"));
+  std::string etag = method == "GET" ? etag_for(url, dbTag) : "";
+  std::string headers;
+  if (!etag.empty()) {
+    // Each encoding is a separate representation and needs its own tag.
+    etag = "\"" + etag + (gzip ? "-gz\"" : "\"");
+    headers = "ETag: " + etag + "\r\nCache-Control: no-cache\r\nVary: Accept-Encoding\r\n";
+    if (etag_matches(get_header(req, "if-none-match"), etag)) {
+      // A revalidated lookup is still a lookup for the top-N statistics.
+      if (url.rfind("/api/lookup", 0) == 0 && get_query_param(url, "all") != "1") {
+        const std::string mac = get_query_param(url, "mac");
+        if (!mac.empty()) record_lookup(mac, db().lookup(mac));
+      }
+      metrics_.count_status(304);
+      if (trace) trace->status = 304;
+      std::string resp = http_response(304, "", "", headers);
+      stamp(trace, RequestTrace::Serialize);
+      return resp;
+    }
+  }
+  stamp(trace, RequestTrace::Parse);
+
+  int status = 200;
+  std::string ct = "text/plain";
+  std::string body = handle_request(req, status, ct, trace);
+  metrics_.count_status(status);
+  if (trace) trace->status = static_cast<uint16_t>(status);
+  if (status != 200) {
+    std::string resp = http_response(status, ct, body);
+    stamp(trace, RequestTrace::Serialize);
+    return resp;
+  }
+
+  if (gzip && body.size() >= kMinGzipSize) {
+    std::string gz = is_index(url) && !indexGz_.empty() ? indexGz_ : util::gzip::compress(body);
+    if (!gz.empty()) {
+      headers += "Content-Encoding: gzip\r\n";
+      body.swap(gz);
+    }
+  }
+  std::string resp = http_response(status, ct, body, headers);
+  stamp(trace, RequestTrace::Serialize);
+  return resp;
+}
+
+std::string HttpServer::reject(int status, RequestTrace* trace) {
+  metrics_.count_status(status);
+  if (trace) trace->status = static_cast<uint16_t>(status);
+  std::string extra = status == 429 ? "Retry-After: 1\r\n" : "";
+  return http_response(status, "text/plain", status_text(status), extra);
+}
+
+std::string HttpServer::respond_to(const std::string& req, const std::string& peer, bool complete,
+                                   RequestTrace* trace) {
+  const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+  if (!limiter_->allow(peer, now)) {
+    metrics_.rateLimited.fetch_add(1, std::memory_order_relaxed);
+    return reject(429, trace);
+  }
+  if (!complete) {
+    metrics_.tooLarge.fetch_add(1, std::memory_order_relaxed);
+    return reject(431, trace);
+  }
+  return respond(req, trace);
+}
+
+// Reads until the end of the headers, EOF, or maxBytes.
+static ReadState read_request(int fd, size_t maxBytes, std::string& req) {
+  req.resize(maxBytes);
+  size_t got = 0;
+  while (got < maxBytes) {
+    ssize_t n = ::read(fd, &req[got], maxBytes - got);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      req.resize(got);
+      return ReadState::TimedOut;
+    }
+    if (n <= 0) break;
+    got += static_cast<size_t>(n);
+    req.resize(got);
+    if (headers_complete(req)) return ReadState::Complete;
+    req.resize(maxBytes);
+  }
+  req.resize(got);
+  if (got == 0) return ReadState::Closed;
+  return got >= maxBytes ? ReadState::TooLarge : ReadState::Complete;
+}
+
+// Sends all of data; a send that stalls past SO_SNDTIMEO fails with EAGAIN.
+// Returns the bytes sent, or -1 with errno set.
+static ssize_t send_all(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return -1;
+    sent += static_cast<size_t>(n);
+  }
+  return static_cast<ssize_t>(sent);
+}
+
+int HttpServer::open_listener(const ListenAddr& la, bool reusePort, bool v6only) {
+  sockaddr_storage ss{};
+  socklen_t len = 0;
+  auto* v4 = reinterpret_cast<sockaddr_in*>(&ss);
+  auto* v6 = reinterpret_cast<sockaddr_in6*>(&ss);
+  if (inet_pton(AF_INET, la.host.c_str(), &v4->sin_addr) == 1) {
+    v4->sin_family = AF_INET;
+    v4->sin_port = htons(static_cast<uint16_t>(la.port));
+    len = sizeof(*v4);
+  } else if (inet_pton(AF_INET6, la.host.c_str(), &v6->sin6_addr) == 1) {
+    v6->sin6_family = AF_INET6;
+    v6->sin6_port = htons(static_cast<uint16_t>(la.port));
+    len = sizeof(*v6);
+  } else {
+    std::cerr << "Invalid host IP: " << la.host << "\n";
+    return -1;
+  }
+
+  int fd = ::socket(ss.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
   if (fd < 0) {
     std::cerr << "socket() failed\n";
-    return 1;
+    return -1;
   }
 
   int opt = 1;
   setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-  sockaddr_in addr{};
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(static_cast<uint16_t>(port_));
-  if (inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) != 1) {
-    std::cerr << "Invalid host IP: " << host_ << "\n";
-    ::close(fd);
-    return 1;
+  if (reusePort) setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+  if (ss.ss_family == AF_INET6) {
+    int only = v6only ? 1 : 0;
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &only, sizeof(only));
   }
 
-  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
-    std::cerr << "bind() failed (host/port available?)\n";
+  if (bind(fd, reinterpret_cast<sockaddr*>(&ss), len) != 0) {
+    std::cerr << "bind() failed for " << la.host << " port " << la.port
+              << " (host/port available?)\n";
     ::close(fd);
-    return 1;
+    return -1;
   }
 
-  if (listen(fd, 64) != 0) {
+  const int backlog = static_cast<int>(std::min<size_t>(SOMAXCONN, std::max<size_t>(64, limits_.maxConnections)));
+  if (listen(fd, backlog) != 0) {
     std::cerr << "listen() failed\n";
     ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// "::" accepts IPv4 too unless an IPv4 address is listed for the same port,
+// in which case that socket owns IPv4 and this one is IPv6 only.
+static bool want_v6only(const std::vector<ListenAddr>& all, const ListenAddr& la) {
+  in6_addr any{};
+  if (inet_pton(AF_INET6, la.host.c_str(), &any) != 1) return false;
+  if (!IN6_IS_ADDR_UNSPECIFIED(&any)) return true;
+  in_addr v4{};
+  for (const auto& other : all) {
+    if (other.port == la.port && inet_pton(AF_INET, other.host.c_str(), &v4) == 1) return true;
+  }
+  return false;
+}
+
+const oui::ManufDB& HttpServer::db() const {
+  if (t_pinned) return *t_pinned;
+  return t_replica ? *t_replica : *db_;
+}
+
+void HttpServer::prepare_worker(unsigned w) {
+  t_replica = nullptr;
+  if (!replicas_.empty()) {
+    const DbReplica& r = replicas_[w % replicas_.size()];
+    t_replica = r.db;
+    if (!r.cpus.empty()) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int cpu : r.cpus) CPU_SET(cpu, &set);
+      if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        std::cerr << "worker " << w << ": sched_setaffinity failed: " << std::strerror(errno) << "\n";
+      }
+    }
+  }
+  if (prewarm_) {
+    stats_.warm();
+    auto warm = [](const oui::ManufDB& d) {
+      if (auto image = d.compiled()) {
+        size_t found = 0;
+        for (uint32_t i = 0; i < image->entry_count(); i++) found += d.lookup(image->entries()[i].prefix).found;
+        (void)found;
+      }
+    };
+    if (handle_ && !t_replica) t_reader->with([&](const oui::ManufDB& d, uint64_t) { warm(d); });
+    else warm(db());
+  }
+}
+
+int HttpServer::serve_worker(const std::vector<int>& fds, unsigned w) {
+  // One reader slot per worker for the per-request version pins.
+  std::optional<oui::DbHandle::Reader> reader;
+  if (handle_) reader.emplace(handle_->reader());
+  struct Bind {
+    Bind(const HttpServer* s, oui::DbHandle::Reader* r) {
+      t_readerOwner = s;
+      t_reader = r;
+    }
+    ~Bind() {
+      t_readerOwner = nullptr;
+      t_reader = nullptr;
+    }
+  } bind(this, reader ? &*reader : nullptr);
+  prepare_worker(w);
+  if (backend_ == IoBackend::Auto || backend_ == IoBackend::Uring) {
+    int rc = serve_uring(fds);
+    if (rc >= 0) return rc;
+    if (backend_ == IoBackend::Uring) {
+      std::cerr << "io_uring backend unavailable\n";
+      return 1;
+    }
+  }
+  if (backend_ != IoBackend::Blocking) {
+    int rc = serve_async(fds);
+    if (rc >= 0) return rc;
+    if (backend_ == IoBackend::Epoll) {
+      std::cerr << "epoll backend unavailable\n";
+      return 1;
+    }
+  }
+  return serve_blocking(fds);
+}
+
+int HttpServer::serve_forever() {
+  if (listen_.empty()) {
+    std::cerr << "no listen address\n";
     return 1;
   }
 
+  // Workers never share a socket: with SO_REUSEPORT each gets its own set.
+  const bool reusePort = workers_ > 1;
+  std::vector<std::vector<int>> sockets(workers_);
+  bool ok = true;
+  for (auto& fds : sockets) {
+    for (const auto& la : listen_) {
+      int fd = ok ? open_listener(la, reusePort, want_v6only(listen_, la)) : -1;
+      if (fd < 0) ok = false;
+      else fds.push_back(fd);
+    }
+  }
+
+  std::mutex stopMu;
+  std::condition_variable stopCv;
+  bool stop = false;
+  std::thread snapshots;
+  if (ok && !statsPath_.empty()) {
+    snapshots = std::thread([&] {
+      std::unique_lock<std::mutex> lock(stopMu);
+      while (!stopCv.wait_for(lock, std::chrono::seconds(statsIntervalSec_), [&] { return stop; })) {
+        if (!stats_.save(statsPath_, LookupStats::kCandidates)) {
+          std::cerr << "stats snapshot failed: " << statsPath_ << "\n";
+        }
+      }
+    });
+  }
+
+  // SIGUSR1 dumps the flight recorder. Blocked before the workers start, so
+  // they inherit the mask and only the dump thread takes the signal.
+  sigset_t usr1;
+  sigset_t oldMask;
+  sigemptyset(&usr1);
+  sigaddset(&usr1, SIGUSR1);
+  std::atomic<bool> stopDump{false};
+  std::thread dumper;
+  if (ok && trace_.enabled()) {
+    pthread_sigmask(SIG_BLOCK, &usr1, &oldMask);
+    dumper = std::thread([&] {
+      int sig = 0;
+      while (sigwait(&usr1, &sig) == 0 && !stopDump.load()) {
+        if (!trace_.dump(traceDumpPath_, SIZE_MAX)) {
+          std::cerr << "slow request dump failed: " << traceDumpPath_ << "\n";
+        }
+      }
+    });
+  }
+
+  int rc = 1;
+  if (ok) {
+    std::vector<int> results(workers_, 0);
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < workers_; w++) {
+      threads.emplace_back([this, &sockets, &results, w] { results[w] = serve_worker(sockets[w], w); });
+    }
+    rc = serve_worker(sockets[0], 0);
+    for (auto& t : threads) t.join();
+    for (int r : results) rc = std::max(rc, r);
+  }
+  if (snapshots.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(stopMu);
+      stop = true;
+    }
+    stopCv.notify_all();
+    snapshots.join();
+  }
+  if (dumper.joinable()) {
+    stopDump.store(true);
+    pthread_kill(dumper.native_handle(), SIGUSR1);
+    dumper.join();
+    pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+  }
+  for (const auto& fds : sockets) {
+    for (int fd : fds) ::close(fd);
+  }
+  return rc;
+}
+
+int HttpServer::serve_blocking(const std::vector<int>& fds) {
+  // One connection at a time per worker; the timeouts keep a slow client
+  // from holding the loop.
+  timeval tv{};
+  tv.tv_sec = limits_.ioTimeoutMs / 1000;
+  tv.tv_usec = (limits_.ioTimeoutMs % 1000) * 1000;
+
+  std::vector<pollfd> pfds;
+  for (int fd : fds) pfds.push_back({fd, POLLIN, 0});
+  size_t next = 0; // round-robin so one busy listener cannot starve the rest
+
   while (true) {
-    sockaddr_in caddr{};
+    if (::poll(pfds.data(), pfds.size(), -1) <= 0) continue;
+    int fd = -1;
+    for (size_t k = 0; k < pfds.size() && fd < 0; k++) {
+      const size_t i = (next + k) % pfds.size();
+      if (pfds[i].revents & POLLIN) {
+        fd = pfds[i].fd;
+        next = i + 1;
+      }
+    }
+    if (fd < 0) continue;
+
+    sockaddr_storage caddr{};
     socklen_t clen = sizeof(caddr);
-    int cfd = accept(fd, (sockaddr*)&caddr, &clen);
+    int cfd = accept4(fd, (sockaddr*)&caddr, &clen, SOCK_CLOEXEC);
     if (cfd < 0) continue;
+    RequestTrace trace;
+    trace_.start(trace);
+    metrics_.connectionsAccepted.fetch_add(1, std::memory_order_relaxed);
+    metrics_.connectionsActive.fetch_add(1, std::memory_order_relaxed);
 
-    // read request (simple)
-    std::string req;
-    req.resize(8192);
-    ssize_t n = read(cfd, req.data(), req.size());
-    if (n <= 0) {
-      ::close(cfd);
-      continue;
+    if (limits_.ioTimeoutMs > 0) {
+      setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+      setsockopt(cfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
     }
-    req.resize((size_t)n);
-
-    int status = 200;
-    std::string ct = "text/plain";
-    std::string body = handle_request(req, status, ct);
 
-    std::string resp = http_response(status, ct, body);
-    (void)write(cfd, resp.data(), resp.size());
+    std::string req;
+    ReadState st = read_request(cfd, limits_.maxRequestBytes, req);
+    trace.received(req);
+    if (st == ReadState::TimedOut) {
+      metrics_.timeouts.fetch_add(1, std::memory_order_relaxed);
+      trace.outcome = RequestTrace::Outcome::ReadTimeout;
+    }
+    if (st == ReadState::Complete || st == ReadState::TooLarge) {
+      std::string resp = respond_to(req, peer_key(caddr), st == ReadState::Complete, &trace);
+      const ssize_t n = send_all(cfd, resp);
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        metrics_.timeouts.fetch_add(1, std::memory_order_relaxed);
+        trace.sent(RequestTrace::Outcome::WriteTimeout, 0);
+      } else {
+        trace.sent(n < 0 ? RequestTrace::Outcome::WriteFailed : RequestTrace::Outcome::Sent,
+                   n < 0 ? 0 : static_cast<size_t>(n));
+      }
+    }
     ::close(cfd);
+    metrics_.connectionsActive.fetch_sub(1, std::memory_order_relaxed);
+    // Connections closed without sending anything are not requests.
+    if (st != ReadState::Closed) trace_.record(trace);
   }
   // unreachable
-  ::close(fd);
   return 0;
 }
 
@@ -1,23 +1,146 @@
 #pragma once
+#include "web/limits.h"
+#include "web/metrics.h"
+#include "web/stats.h"
+#include "web/trace.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
+
+namespace oui {
+class DbHandle;
+class ManufDB;
+struct LookupResult;
+} // namespace oui
 
-namespace oui { class ManufDB; }
+namespace update { class BackgroundUpdater; }
 
 namespace web {
 
+class Executor;
+template <typename T> class Task;
+
+enum class IoBackend {
+  Auto,     // io_uring when the kernel supports it, otherwise epoll
+  Uring,
+  Epoll,    // coroutine per connection on an epoll executor
+  Blocking, // one connection at a time
+};
+
+struct ListenAddr {
+  std::string host; // numeric IPv4 or IPv6 address; "::" is dual-stack
+  int port = 0;
+};
+
+// A copy of the DB for the workers pinned to cpus (one per NUMA node).
+struct DbReplica {
+  const oui::ManufDB* db = nullptr;
+  std::vector<int> cpus; // empty: no pinning
+};
+
 class HttpServer {
 public:
   HttpServer(std::string host, int port, std::string dbPath, oui::ManufDB* db);
+  // Serves whichever version of handle is current when a request starts;
+  // the version stays pinned until its response is built.
+  HttpServer(std::string host, int port, std::string dbPath, oui::DbHandle* handle);
 
+  void set_backend(IoBackend backend) { backend_ = backend; }
+  void set_limits(const ServerLimits& limits);
+  // Replaces the constructor's host/port. Every address gets its own socket.
+  void set_listen(std::vector<ListenAddr> addrs) { listen_ = std::move(addrs); }
+  // With n > 1 each worker thread runs its own event loop over its own
+  // SO_REUSEPORT sockets, so the kernel spreads connections across them.
+  void set_workers(unsigned n) { workers_ = n ? n : 1; }
+  // Worker w pins itself to replicas[w % n].cpus and looks up in that
+  // replica instead of the constructor's DB.
+  void set_replicas(std::vector<DbReplica> replicas) { replicas_ = std::move(replicas); }
+  // Workers run one lookup per DB entry and set up their per-thread state
+  // before accepting, so the first requests do not pay for page faults.
+  void set_prewarm(bool on) { prewarm_ = on; }
+  // Writes the lookup top-N statistics to path every intervalSec seconds.
+  void set_stats_snapshot(std::string path, int intervalSec) {
+    statsPath_ = std::move(path);
+    statsIntervalSec_ = intervalSec > 0 ? intervalSec : 60;
+  }
+  // Flight recorder: requests taking slowUs or more (accept to last byte
+  // sent) are kept apart from the ring of recent ones. GET /debug/slow shows
+  // both; SIGUSR1 writes them to dumpPath ("" for stderr). slowUs < 0 turns
+  // recording off.
+  void set_trace(int64_t slowUs, std::string dumpPath) {
+    trace_.set_threshold_us(slowUs);
+    traceDumpPath_ = std::move(dumpPath);
+  }
+  // Adds the updater's DB version, age and counters to GET /metrics.
+  void set_updater(const update::BackgroundUpdater* updater) { updater_ = updater; }
+  // ETag base for a version published to the handle after startup
+  // (update::content_tag). Until it arrives that version's answers carry no
+  // ETag, so no request thread ever hashes an image.
+  void set_db_tag(uint64_t version, std::string tag);
   int serve_forever();
 
+  // Response bytes for one raw request from peer: admission checks (rate
+  // limit, request size), then respond(). complete is false when the headers
+  // did not fit in limits_.maxRequestBytes. Every backend ends up here; the
+  // fuzz targets call it directly.
+  std::string respond_to(const std::string& req, const std::string& peer, bool complete,
+                         RequestTrace* trace = nullptr);
+
 private:
-  std::string host_;
-  int port_;
+  std::vector<ListenAddr> listen_;
+  unsigned workers_ = 1;
   std::string dbPath_;
   oui::ManufDB* db_;
+  oui::DbHandle* handle_ = nullptr;
+  const update::BackgroundUpdater* updater_ = nullptr;
+  std::vector<DbReplica> replicas_;
+  bool prewarm_ = false;
+  IoBackend backend_ = IoBackend::Auto;
+  std::string dbTag_;      // content hash of the loaded DB, used in ETags
+  mutable std::mutex tagMu_;
+  std::vector<std::pair<uint64_t, std::string>> tags_; // handle version -> dbTag, newest last
+  std::string indexTag_;
+  std::string indexGz_;    // kIndexHtml compressed once at startup
+  ServerLimits limits_;
+  std::unique_ptr<RateLimiter> limiter_;
+  Metrics metrics_;
+  LookupStats stats_;
+  std::string statsPath_;
+  int statsIntervalSec_ = 60;
+  FlightRecorder trace_;
+  std::string traceDumpPath_;
+
+  // trace (may be null) gets the Parse, Lookup and Serialize stamps.
+  std::string handle_request(const std::string& req, int& status, std::string& contentType,
+                             RequestTrace* trace);
+  // Full HTTP response bytes for one raw request (ETag/304, gzip negotiation).
+  std::string respond(const std::string& req, RequestTrace* trace = nullptr);
+  // respond() once the DB is pinned; dbTag is that DB's content hash.
+  std::string respond_db(const std::string& req, const std::string& dbTag, RequestTrace* trace);
+  std::string etag_for(const std::string& url, const std::string& dbTag) const;
+  // Counts a /api/lookup answer (200 or 304) in stats_.
+  void record_lookup(const std::string& mac, const oui::LookupResult& r);
+  // Cached per thread; empty while set_db_tag() has not seen version.
+  const std::string& db_tag(uint64_t version) const;
+  std::string reject(int status, RequestTrace* trace = nullptr);
 
-  std::string handle_request(const std::string& req, int& status, std::string& contentType);
+  int open_listener(const ListenAddr& addr, bool reusePort, bool v6only);
+  // The calling worker's DB: the version pinned for the current request, its
+  // NUMA replica, or the constructor's DB.
+  const oui::ManufDB& db() const;
+  void prepare_worker(unsigned w);
+  int serve_worker(const std::vector<int>& fds, unsigned w);
+  int serve_blocking(const std::vector<int>& fds);
+  // Returns -1 when io_uring is unavailable so the caller can fall back.
+  int serve_uring(const std::vector<int>& fds);
+  // Coroutine backend (http_server_async.cpp); -1 when epoll is unavailable.
+  int serve_async(const std::vector<int>& fds);
+  Task<void> accept_loop(Executor& ex, int listenFd);
+  Task<void> serve_connection(Executor& ex, int fd, std::string peer);
 };
 
 } // namespace web
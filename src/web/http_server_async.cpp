@@ -0,0 +1,152 @@
+// Coroutine backend for HttpServer: every connection is a Task on the
+// worker's epoll Executor, so a slow client only parks its own coroutine and
+// thousands of requests can be in flight per thread. Reads and writes are
+// plain non-blocking syscalls that co_await readiness on EAGAIN.
+#include "web/http_server.h"
+#include "web/executor.h"
+#include "web/task.h"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <string_view>
+
+namespace web {
+
+enum class SendState { Sent, Failed, TimedOut };
+
+// Reads until the end of the headers, EOF, or maxBytes.
+static Task<ReadState> recv_request(Executor& ex, int fd, size_t maxBytes, int timeoutMs,
+                                    std::string& req) {
+  req.resize(maxBytes);
+  size_t got = 0;
+  while (got < maxBytes) {
+    ssize_t n = ::recv(fd, &req[got], maxBytes - got, 0);
+    if (n > 0) {
+      got += static_cast<size_t>(n);
+      req.resize(got);
+      if (headers_complete(req)) co_return ReadState::Complete;
+      req.resize(maxBytes);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (co_await ex.readable(fd, timeoutMs)) continue;
+      req.resize(got);
+      co_return ReadState::TimedOut;
+    }
+    break;
+  }
+  req.resize(got);
+  if (got == 0) co_return ReadState::Closed;
+  co_return got >= maxBytes ? ReadState::TooLarge : ReadState::Complete;
+}
+
+// Large bodies go out as far as the socket buffer allows, then the
+// coroutine waits for room instead of blocking the worker.
+static Task<SendState> send_all(Executor& ex, int fd, std::string_view data, int timeoutMs) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      sent += static_cast<size_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (co_await ex.writable(fd, timeoutMs)) continue;
+      co_return SendState::TimedOut;
+    }
+    co_return SendState::Failed;
+  }
+  co_return SendState::Sent;
+}
+
+Task<> HttpServer::serve_connection(Executor& ex, int fd, std::string peer) {
+  RequestTrace trace;
+  trace_.start(trace);
+  std::string req;
+  const ReadState st = co_await recv_request(ex, fd, limits_.maxRequestBytes, limits_.ioTimeoutMs, req);
+  trace.received(req);
+  if (st == ReadState::TimedOut) {
+    metrics_.timeouts.fetch_add(1, std::memory_order_relaxed);
+    trace.outcome = RequestTrace::Outcome::ReadTimeout;
+  }
+  if (st == ReadState::Complete || st == ReadState::TooLarge) {
+    const std::string resp = respond_to(req, peer, st == ReadState::Complete, &trace);
+    switch (co_await send_all(ex, fd, resp, limits_.ioTimeoutMs)) {
+      case SendState::Sent:
+        trace.sent(RequestTrace::Outcome::Sent, resp.size());
+        break;
+      case SendState::TimedOut:
+        metrics_.timeouts.fetch_add(1, std::memory_order_relaxed);
+        trace.sent(RequestTrace::Outcome::WriteTimeout, 0);
+        break;
+      case SendState::Failed:
+        trace.sent(RequestTrace::Outcome::WriteFailed, 0);
+        break;
+    }
+  }
+  ex.close(fd);
+  metrics_.connectionsActive.fetch_sub(1, std::memory_order_relaxed);
+  if (st != ReadState::Closed) trace_.record(trace);
+}
+
+Task<> HttpServer::accept_loop(Executor& ex, int listenFd) {
+  // Under a steady stream of new connections accept4 never says EAGAIN;
+  // going back through epoll now and then lets waiting connections run.
+  constexpr int kAcceptBurst = 16;
+  int burst = 0;
+  while (true) {
+    if (++burst > kAcceptBurst) {
+      burst = 0;
+      co_await ex.readable(listenFd, 0);
+    }
+    sockaddr_storage caddr{};
+    socklen_t clen = sizeof(caddr);
+    int cfd = accept4(listenFd, (sockaddr*)&caddr, &clen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (cfd < 0) {
+      // EAGAIN, or out of fds: let the other connections run first.
+      if (errno != EINTR && errno != ECONNABORTED) {
+        burst = 0;
+        co_await ex.readable(listenFd, 0);
+      }
+      continue;
+    }
+
+    // Shared across workers, so the limit holds for the whole process.
+    if (metrics_.connectionsActive.load(std::memory_order_relaxed) >=
+        static_cast<int64_t>(limits_.maxConnections)) {
+      metrics_.connectionsRejected.fetch_add(1, std::memory_order_relaxed);
+      const std::string busy = reject(503);
+      ::send(cfd, busy.data(), busy.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+      ::close(cfd);
+      continue;
+    }
+    metrics_.connectionsAccepted.fetch_add(1, std::memory_order_relaxed);
+    metrics_.connectionsActive.fetch_add(1, std::memory_order_relaxed);
+    ex.spawn(serve_connection(ex, cfd, peer_key(caddr)));
+  }
+}
+
+int HttpServer::serve_async(const std::vector<int>& listenFds) {
+  Executor ex;
+  if (!ex.init()) return -1;
+  // Deliver connections once the request has arrived, so the first recv
+  // usually succeeds without a trip through epoll.
+  const int deferSec = std::max(1, limits_.ioTimeoutMs / 1000);
+  for (int fd : listenFds) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &deferSec, sizeof(deferSec));
+    ex.spawn(accept_loop(ex, fd));
+  }
+  return ex.run();
+}
+
+} // namespace web
@@ -0,0 +1,409 @@
+// io_uring backend for HttpServer. Talks to the kernel through raw syscalls so
+// there is no liburing dependency; any setup failure makes serve_uring()
+// return -1 and serve_forever() falls back to the blocking loop.
+#include "web/http_server.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace web {
+
+namespace {
+
+constexpr unsigned kQueueDepth = 256;
+constexpr unsigned kBufferCount = 256;
+constexpr uint16_t kBufferGroup = 1;
+
+enum class Op : uint64_t { Accept = 1, Recv, Send, Close, Provide, Timeout };
+
+uint64_t tag(Op op, uint32_t slot) {
+  return (static_cast<uint64_t>(op) << 32) | slot;
+}
+
+Op tag_op(uint64_t t) { return static_cast<Op>(t >> 32); }
+uint32_t tag_slot(uint64_t t) { return static_cast<uint32_t>(t); }
+
+class Ring {
+public:
+  ~Ring() {
+    if (sqes_) ::munmap(sqes_, sqesSize_);
+    if (cqPtr_ && cqPtr_ != sqPtr_) ::munmap(cqPtr_, cqSize_);
+    if (sqPtr_) ::munmap(sqPtr_, sqSize_);
+    if (fd_ >= 0) ::close(fd_);
+  }
+
+  bool init(unsigned entries) {
+    io_uring_params p{};
+    fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (fd_ < 0) return false;
+
+    sqSize_ = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+    cqSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+
+    sqPtr_ = ::mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd_, IORING_OFF_SQ_RING);
+    if (sqPtr_ == MAP_FAILED) { sqPtr_ = nullptr; return false; }
+    if (single) {
+      cqPtr_ = sqPtr_;
+    } else {
+      cqPtr_ = ::mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd_, IORING_OFF_CQ_RING);
+      if (cqPtr_ == MAP_FAILED) { cqPtr_ = nullptr; return false; }
+    }
+    sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<uint8_t*>(sqPtr_);
+    sqHead_ = reinterpret_cast<std::atomic<uint32_t>*>(sq + p.sq_off.head);
+    sqTail_ = reinterpret_cast<std::atomic<uint32_t>*>(sq + p.sq_off.tail);
+    sqMask_ = *reinterpret_cast<uint32_t*>(sq + p.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<uint32_t*>(sq + p.sq_off.array);
+    sqEntries_ = p.sq_entries;
+
+    auto* cq = static_cast<uint8_t*>(cqPtr_);
+    cqHead_ = reinterpret_cast<std::atomic<uint32_t>*>(cq + p.cq_off.head);
+    cqTail_ = reinterpret_cast<std::atomic<uint32_t>*>(cq + p.cq_off.tail);
+    cqMask_ = *reinterpret_cast<uint32_t*>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    localTail_ = sqTail_->load(std::memory_order_relaxed);
+    return supports({IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_CLOSE,
+                     IORING_OP_PROVIDE_BUFFERS, IORING_OP_LINK_TIMEOUT});
+  }
+
+  // Returns a zeroed SQE, flushing queued ones first if the ring is full.
+  io_uring_sqe* sqe() {
+    if (localTail_ - sqHead_->load(std::memory_order_acquire) >= sqEntries_) submit(0);
+    const uint32_t idx = localTail_ & sqMask_;
+    io_uring_sqe* s = &sqes_[idx];
+    std::memset(s, 0, sizeof(*s));
+    sqArray_[idx] = idx;
+    localTail_++;
+    pending_++;
+    return s;
+  }
+
+  // One syscall submits everything queued and optionally waits for completions.
+  int submit(unsigned waitFor) {
+    sqTail_->store(localTail_, std::memory_order_release);
+    const unsigned n = pending_;
+    pending_ = 0;
+    unsigned flags = waitFor ? IORING_ENTER_GETEVENTS : 0;
+    int rc;
+    do {
+      rc = static_cast<int>(::syscall(__NR_io_uring_enter, fd_, n, waitFor, flags, nullptr, 0));
+    } while (rc < 0 && errno == EINTR);
+    return rc;
+  }
+
+  template <typename F>
+  void drain(F&& fn) {
+    uint32_t head = cqHead_->load(std::memory_order_relaxed);
+    const uint32_t tail = cqTail_->load(std::memory_order_acquire);
+    for (; head != tail; head++) {
+      io_uring_cqe cqe = cqes_[head & cqMask_];
+      cqHead_->store(head + 1, std::memory_order_release);
+      fn(cqe);
+    }
+  }
+
+private:
+  int fd_ = -1;
+  void* sqPtr_ = nullptr;
+  void* cqPtr_ = nullptr;
+  size_t sqSize_ = 0;
+  size_t cqSize_ = 0;
+  size_t sqesSize_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+
+  std::atomic<uint32_t>* sqHead_ = nullptr;
+  std::atomic<uint32_t>* sqTail_ = nullptr;
+  uint32_t sqMask_ = 0;
+  uint32_t* sqArray_ = nullptr;
+  uint32_t sqEntries_ = 0;
+  uint32_t localTail_ = 0;
+  unsigned pending_ = 0;
+
+  std::atomic<uint32_t>* cqHead_ = nullptr;
+  std::atomic<uint32_t>* cqTail_ = nullptr;
+  uint32_t cqMask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  bool supports(std::initializer_list<int> ops) {
+    const size_t len = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    std::vector<uint8_t> buf(len);
+    auto* probe = reinterpret_cast<io_uring_probe*>(buf.data());
+    if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+      return false;
+    }
+    for (int op : ops) {
+      if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+    }
+    return true;
+  }
+};
+
+struct Conn {
+  int fd = -1;
+  bool limited = false; // over the rate limit; answered 429 once the request arrives
+  std::string in;       // request bytes so far; a request may take several recvs
+  std::string out;
+  size_t sent = 0;      // bytes of out already sent; a send may complete short
+  RequestTrace trace;
+};
+
+// Sent synchronously when maxConnections is reached, before any slot is used.
+const char kBusyResponse[] =
+  "HTTP/1.1 503 Service Unavailable\r\n"
+  "Content-Type: text/plain\r\n"
+  "Content-Length: 19\r\n"
+  "Retry-After: 1\r\n"
+  "Connection: close\r\n"
+  "\r\n"
+  "Service Unavailable";
+
+} // namespace
+
+int HttpServer::serve_uring(const std::vector<int>& listenFds) {
+  Ring ring;
+  if (!ring.init(kQueueDepth)) return -1;
+
+  // Each recv fills at most one provided buffer; the request is gathered in
+  // Conn::in up to maxRequestBytes.
+  const unsigned bufSize = static_cast<unsigned>(
+    std::clamp<size_t>(limits_.maxRequestBytes, 1024, 65536));
+  std::vector<char> buffers(size_t(kBufferCount) * bufSize);
+  std::deque<Conn> conns; // stable addresses while sends are in flight
+  std::vector<uint32_t> freeSlots;
+  bool multishot = true;
+
+  __kernel_timespec timeout{};
+  timeout.tv_sec = limits_.ioTimeoutMs / 1000;
+  timeout.tv_nsec = static_cast<long long>(limits_.ioTimeoutMs % 1000) * 1000000;
+
+  auto provide = [&](uint16_t bid, unsigned count) {
+    io_uring_sqe* s = ring.sqe();
+    s->opcode = IORING_OP_PROVIDE_BUFFERS;
+    s->fd = static_cast<int>(count);
+    s->addr = reinterpret_cast<uint64_t>(buffers.data() + size_t(bid) * bufSize);
+    s->len = bufSize;
+    s->off = bid;
+    s->buf_group = kBufferGroup;
+    s->user_data = tag(Op::Provide, 0);
+  };
+
+  // The accept's slot field carries the listener index.
+  auto arm_accept = [&](uint32_t listener) {
+    io_uring_sqe* s = ring.sqe();
+    s->opcode = IORING_OP_ACCEPT;
+    s->fd = listenFds[listener];
+    s->accept_flags = SOCK_CLOEXEC;
+    if (multishot) s->ioprio = IORING_ACCEPT_MULTISHOT;
+    s->user_data = tag(Op::Accept, listener);
+  };
+
+  // Bounds the preceding SQE (which must carry IOSQE_IO_LINK) by ioTimeoutMs.
+  auto link_timeout = [&](uint32_t slot) {
+    io_uring_sqe* t = ring.sqe();
+    t->opcode = IORING_OP_LINK_TIMEOUT;
+    t->fd = -1;
+    t->addr = reinterpret_cast<uint64_t>(&timeout);
+    t->len = 1;
+    t->user_data = tag(Op::Timeout, slot);
+  };
+  const bool timed = limits_.ioTimeoutMs > 0;
+
+  auto arm_recv = [&](uint32_t slot) {
+    const Conn& c = conns[slot];
+    io_uring_sqe* r = ring.sqe();
+    r->opcode = IORING_OP_RECV;
+    r->fd = c.fd;
+    r->len = static_cast<uint32_t>(std::min<size_t>(bufSize, limits_.maxRequestBytes - c.in.size()));
+    r->flags = IOSQE_BUFFER_SELECT | (timed ? IOSQE_IO_LINK : 0);
+    r->buf_group = kBufferGroup;
+    r->user_data = tag(Op::Recv, slot);
+    if (timed) link_timeout(slot);
+  };
+
+  // Sends what is left of out; called again after a short completion.
+  auto arm_send = [&](uint32_t slot) {
+    const Conn& c = conns[slot];
+    io_uring_sqe* w = ring.sqe();
+    w->opcode = IORING_OP_SEND;
+    w->fd = c.fd;
+    w->addr = reinterpret_cast<uint64_t>(c.out.data() + c.sent);
+    w->len = static_cast<uint32_t>(c.out.size() - c.sent);
+    w->msg_flags = MSG_NOSIGNAL;
+    w->flags = timed ? IOSQE_IO_LINK : 0;
+    w->user_data = tag(Op::Send, slot);
+    if (timed) link_timeout(slot);
+  };
+
+  auto close_conn = [&](uint32_t slot) {
+    io_uring_sqe* s = ring.sqe();
+    s->opcode = IORING_OP_CLOSE;
+    s->fd = conns[slot].fd;
+    s->user_data = tag(Op::Close, slot);
+  };
+
+  provide(0, kBufferCount);
+  for (uint32_t i = 0; i < listenFds.size(); i++) arm_accept(i);
+  if (ring.submit(0) < 0) return -1;
+
+  while (true) {
+    if (ring.submit(1) < 0 && errno != EBUSY) {
+      std::cerr << "io_uring_enter failed: " << std::strerror(errno) << "\n";
+      return 1;
+    }
+
+    ring.drain([&](const io_uring_cqe& cqe) {
+      const uint32_t slot = tag_slot(cqe.user_data);
+      switch (tag_op(cqe.user_data)) {
+        case Op::Accept: {
+          if (cqe.res == -EINVAL && multishot) {
+            multishot = false; // pre-5.19 kernel: re-arm one accept at a time
+            arm_accept(slot);
+            break;
+          }
+          if (!(cqe.flags & IORING_CQE_F_MORE)) arm_accept(slot);
+          if (cqe.res < 0) break;
+
+          // Shared across workers, so the limit holds for the whole process.
+          if (metrics_.connectionsActive.load(std::memory_order_relaxed) >=
+              static_cast<int64_t>(limits_.maxConnections)) {
+            metrics_.connectionsRejected.fetch_add(1, std::memory_order_relaxed);
+            metrics_.count_status(503);
+            ::send(cqe.res, kBusyResponse, sizeof(kBusyResponse) - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+            ::close(cqe.res);
+            break;
+          }
+
+          uint32_t s;
+          if (!freeSlots.empty()) {
+            s = freeSlots.back();
+            freeSlots.pop_back();
+          } else {
+            s = static_cast<uint32_t>(conns.size());
+            conns.emplace_back();
+          }
+          metrics_.connectionsAccepted.fetch_add(1, std::memory_order_relaxed);
+          metrics_.connectionsActive.fetch_add(1, std::memory_order_relaxed);
+          conns[s].fd = cqe.res;
+          conns[s].limited = false;
+          conns[s].in.clear();
+          conns[s].sent = 0;
+          conns[s].trace = RequestTrace();
+          trace_.start(conns[s].trace);
+          if (limiter_->enabled()) {
+            const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now().time_since_epoch()).count();
+            conns[s].limited = !limiter_->allow(peer_of(cqe.res), now);
+          }
+          arm_recv(s);
+          break;
+        }
+        case Op::Recv: {
+          const bool hasBuf = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+          const uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+          Conn& c = conns[slot];
+          // EOF after part of a request answers what arrived, as the other
+          // backends do; EOF before anything is just a closed connection.
+          if (cqe.res < 0 || (cqe.res > 0 && !hasBuf) || (cqe.res == 0 && c.in.empty())) {
+            if (cqe.res == -ECANCELED) {
+              metrics_.timeouts.fetch_add(1, std::memory_order_relaxed);
+              RequestTrace& t = c.trace;
+              t.received(c.in);
+              t.outcome = RequestTrace::Outcome::ReadTimeout;
+              trace_.record(t);
+            }
+            if (hasBuf) provide(bid, 1);
+            close_conn(slot);
+            break;
+          }
+          if (cqe.res > 0) {
+            c.in.append(buffers.data() + size_t(bid) * bufSize, static_cast<size_t>(cqe.res));
+            provide(bid, 1);
+          }
+
+          // Headers split over several segments: read on into the same slot.
+          const bool complete = cqe.res == 0 || headers_complete(c.in);
+          if (!complete && !c.limited && c.in.size() < limits_.maxRequestBytes) {
+            arm_recv(slot);
+            break;
+          }
+          const std::string& req = c.in;
+          c.trace.received(req);
+          if (c.limited) {
+            metrics_.rateLimited.fetch_add(1, std::memory_order_relaxed);
+            c.out = reject(429, &c.trace);
+          } else if (!complete) {
+            metrics_.tooLarge.fetch_add(1, std::memory_order_relaxed);
+            c.out = reject(431, &c.trace);
+          } else {
+            c.out = respond(req, &c.trace);
+          }
+          c.sent = 0;
+          arm_send(slot);
+          break;
+        }
+        case Op::Send: {
+          // Close after the send finishes (or times out) rather than linking,
+          // so a cancelled send still releases the socket.
+          Conn& c = conns[slot];
+          RequestTrace& t = c.trace;
+          if (cqe.res > 0) {
+            c.sent += static_cast<size_t>(cqe.res);
+            // Short send (a slow reader filled the socket buffer): send the
+            // rest, with a fresh timeout.
+            if (c.sent < c.out.size()) {
+              arm_send(slot);
+              break;
+            }
+          }
+          if (cqe.res == -ECANCELED) {
+            metrics_.timeouts.fetch_add(1, std::memory_order_relaxed);
+            t.sent(RequestTrace::Outcome::WriteTimeout, 0);
+          } else {
+            t.sent(cqe.res < 0 ? RequestTrace::Outcome::WriteFailed : RequestTrace::Outcome::Sent,
+                   cqe.res < 0 ? 0 : c.sent);
+          }
+          trace_.record(t);
+          close_conn(slot);
+          break;
+        }
+        case Op::Provide:
+        case Op::Timeout:
+          break;
+        case Op::Close: {
+          conns[slot].fd = -1;
+          conns[slot].in.clear();
+          conns[slot].out.clear();
+          freeSlots.push_back(slot);
+          metrics_.connectionsActive.fetch_sub(1, std::memory_order_relaxed);
+          break;
+        }
+      }
+    });
+  }
+  return 0;
+}
+
+} // namespace web
@@ -0,0 +1,100 @@
+#include "web/limits.h"
+#include "util/str.h"
+
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace web {
+
+RateLimiter::RateLimiter(double ratePerSec, double burst)
+  : rate_(ratePerSec),
+    burst_(burst > 0 ? burst : std::max(1.0, 2 * ratePerSec)),
+    shards_(new Shard[kShards]) {}
+
+bool RateLimiter::allow(const std::string& peer, int64_t nowNs) {
+  if (!enabled()) return true;
+  Shard& s = shards_[util::str::fnv1a64(peer.data(), peer.size()) % kShards];
+  std::lock_guard<std::mutex> lock(s.mu);
+
+  auto it = s.buckets.find(peer);
+  if (it == s.buckets.end()) {
+    if (s.buckets.size() >= kMaxPerShard) evict_idle(s, nowNs);
+    it = s.buckets.emplace(peer, Bucket{burst_, nowNs}).first;
+  }
+  Bucket& b = it->second;
+  b.tokens = std::min(burst_, b.tokens + (nowNs - b.lastNs) * 1e-9 * rate_);
+  b.lastNs = nowNs;
+  if (b.tokens < 1.0) return false;
+  b.tokens -= 1.0;
+  return true;
+}
+
+size_t RateLimiter::tracked() const {
+  size_t n = 0;
+  for (size_t i = 0; i < kShards; i++) {
+    std::lock_guard<std::mutex> lock(shards_[i].mu);
+    n += shards_[i].buckets.size();
+  }
+  return n;
+}
+
+// A bucket that would have refilled completely carries no state worth keeping.
+// If that is not enough, the least recently seen eighth goes, so a flood of
+// new addresses does not reset the buckets of clients still sending.
+void RateLimiter::evict_idle(Shard& s, int64_t nowNs) {
+  for (auto it = s.buckets.begin(); it != s.buckets.end();) {
+    const Bucket& b = it->second;
+    if (b.tokens + (nowNs - b.lastNs) * 1e-9 * rate_ >= burst_) {
+      it = s.buckets.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (s.buckets.size() < kMaxPerShard) return;
+
+  std::vector<int64_t> seen;
+  seen.reserve(s.buckets.size());
+  for (const auto& kv : s.buckets) seen.push_back(kv.second.lastNs);
+  const size_t keep = kMaxPerShard - kMaxPerShard / 8;
+  auto cut = seen.begin() + (seen.size() - keep);
+  std::nth_element(seen.begin(), cut, seen.end());
+  const int64_t oldest = *cut;
+  for (auto it = s.buckets.begin(); it != s.buckets.end() && s.buckets.size() > keep;) {
+    if (it->second.lastNs <= oldest) {
+      it = s.buckets.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::string peer_key(const sockaddr_storage& ss) {
+  if (ss.ss_family == AF_INET) {
+    const auto& a = reinterpret_cast<const sockaddr_in&>(ss).sin_addr;
+    return std::string(reinterpret_cast<const char*>(&a), sizeof(a));
+  }
+  if (ss.ss_family == AF_INET6) {
+    const auto& a = reinterpret_cast<const sockaddr_in6&>(ss).sin6_addr;
+    // IPv4 clients of a dual-stack socket share the bucket of a plain IPv4 one.
+    if (IN6_IS_ADDR_V4MAPPED(&a)) return std::string(reinterpret_cast<const char*>(&a) + 12, 4);
+    // A client usually holds a whole /64 and can rotate through it, so the
+    // /64 is one client.
+    return std::string(reinterpret_cast<const char*>(&a), 8);
+  }
+  return "";
+}
+
+std::string peer_of(int fd) {
+  sockaddr_storage ss{};
+  socklen_t len = sizeof(ss);
+  if (::getpeername(fd, reinterpret_cast<sockaddr*>(&ss), &len) != 0) return "";
+  return peer_key(ss);
+}
+
+bool headers_complete(const std::string& req) {
+  return req.find("\r\n\r\n") != std::string::npos || req.find("\n\n") != std::string::npos;
+}
+
+} // namespace web
@@ -0,0 +1,61 @@
+#pragma once
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace web {
+
+struct ServerLimits {
+  double ratePerSec = 0;       // per source IP; 0 disables rate limiting
+  double burst = 0;            // bucket size; 0 means max(1, 2 * rate)
+  size_t maxConnections = 1024;
+  size_t maxRequestBytes = 8192;
+  int ioTimeoutMs = 5000;      // per read / write; 0 disables
+};
+
+// Token buckets keyed by raw peer address, split over independently locked
+// shards so concurrent callers rarely contend.
+class RateLimiter {
+public:
+  RateLimiter(double ratePerSec, double burst);
+
+  bool enabled() const { return rate_ > 0; }
+  bool allow(const std::string& peer, int64_t nowNs);
+  size_t tracked() const;
+
+private:
+  struct Bucket {
+    double tokens = 0;
+    int64_t lastNs = 0;
+  };
+  struct Shard {
+    mutable std::mutex mu;
+    std::unordered_map<std::string, Bucket> buckets;
+  };
+  static constexpr size_t kShards = 64;
+  static constexpr size_t kMaxPerShard = 4096;
+
+  double rate_;
+  double burst_;
+  std::unique_ptr<Shard[]> shards_;
+
+  void evict_idle(Shard& s, int64_t nowNs);
+};
+
+// Rate-limit key for a client: address bytes without the port; the /64 for
+// native IPv6.
+std::string peer_key(const sockaddr_storage& addr);
+std::string peer_of(int fd);
+
+// True once the request buffer holds the blank line ending the headers.
+bool headers_complete(const std::string& req);
+
+// Outcome of reading one request's headers.
+enum class ReadState { Complete, TooLarge, Closed, TimedOut };
+
+} // namespace web
@@ -0,0 +1,66 @@
+#include "web/metrics.h"
+#include "web/limits.h"
+#include "update/background.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace web {
+
+void Metrics::count_status(int status) {
+  auto& c = status < 300 ? responses2xx : status < 400 ? responses3xx
+          : status < 500 ? responses4xx : responses5xx;
+  c.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Counters, sizes and timestamps: printed in full, never through %g, so
+// rate() keeps working past a million.
+static void int_line(std::ostringstream& oss, const char* name, const char* type, int64_t value) {
+  oss << "# TYPE " << name << " " << type << "\n" << name << " " << value << "\n";
+}
+
+// Fractional settings (requests per second, burst).
+static void real_line(std::ostringstream& oss, const char* name, const char* type, double value) {
+  oss << "# TYPE " << name << " " << type << "\n" << name << " " << value << "\n";
+}
+
+std::string Metrics::render(const ServerLimits& limits, size_t trackedClients) const {
+  std::ostringstream oss;
+  int_line(oss, "oui_connections_accepted_total", "counter", static_cast<int64_t>(connectionsAccepted.load()));
+  int_line(oss, "oui_connections_rejected_total", "counter", static_cast<int64_t>(connectionsRejected.load()));
+  int_line(oss, "oui_connections_active", "gauge", connectionsActive.load());
+  int_line(oss, "oui_rate_limited_total", "counter", static_cast<int64_t>(rateLimited.load()));
+  int_line(oss, "oui_requests_too_large_total", "counter", static_cast<int64_t>(tooLarge.load()));
+  int_line(oss, "oui_io_timeouts_total", "counter", static_cast<int64_t>(timeouts.load()));
+  oss << "# TYPE oui_responses_total counter\n"
+      << "oui_responses_total{class=\"2xx\"} " << responses2xx.load() << "\n"
+      << "oui_responses_total{class=\"3xx\"} " << responses3xx.load() << "\n"
+      << "oui_responses_total{class=\"4xx\"} " << responses4xx.load() << "\n"
+      << "oui_responses_total{class=\"5xx\"} " << responses5xx.load() << "\n";
+  int_line(oss, "oui_rate_limit_clients", "gauge", static_cast<int64_t>(trackedClients));
+  real_line(oss, "oui_limit_rate_per_second", "gauge", limits.ratePerSec);
+  real_line(oss, "oui_limit_burst", "gauge", limits.burst);
+  int_line(oss, "oui_limit_max_connections", "gauge", static_cast<int64_t>(limits.maxConnections));
+  int_line(oss, "oui_limit_max_request_bytes", "gauge", static_cast<int64_t>(limits.maxRequestBytes));
+  int_line(oss, "oui_limit_io_timeout_ms", "gauge", limits.ioTimeoutMs);
+  return oss.str();
+}
+
+std::string render_update(const update::BackgroundStatus& s) {
+  const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  std::ostringstream oss;
+  int_line(oss, "oui_db_version", "gauge", static_cast<int64_t>(s.version));
+  int_line(oss, "oui_db_entries", "gauge", static_cast<int64_t>(s.entries));
+  int_line(oss, "oui_db_age_seconds", "gauge", s.loadedAt ? now - s.loadedAt : 0);
+  int_line(oss, "oui_update_checks_total", "counter", static_cast<int64_t>(s.checks));
+  int_line(oss, "oui_update_swaps_total", "counter", static_cast<int64_t>(s.swaps));
+  int_line(oss, "oui_update_failures_total", "counter", static_cast<int64_t>(s.failures));
+  int_line(oss, "oui_update_consecutive_failures", "gauge", static_cast<int64_t>(s.consecutiveFailures));
+  int_line(oss, "oui_update_last_ok", "gauge", s.lastOk ? 1 : 0);
+  int_line(oss, "oui_update_last_check_timestamp_seconds", "gauge", s.lastCheck);
+  int_line(oss, "oui_update_last_success_timestamp_seconds", "gauge", s.lastSuccess);
+  return oss.str();
+}
+
+} // namespace web
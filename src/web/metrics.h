@@ -0,0 +1,32 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace update { struct BackgroundStatus; }
+
+namespace web {
+
+struct ServerLimits;
+
+// Process-wide counters exported at GET /metrics (Prometheus text format).
+struct Metrics {
+  std::atomic<uint64_t> connectionsAccepted{0};
+  std::atomic<uint64_t> connectionsRejected{0}; // over max connections (503)
+  std::atomic<int64_t> connectionsActive{0};
+  std::atomic<uint64_t> rateLimited{0};         // 429
+  std::atomic<uint64_t> tooLarge{0};            // 431
+  std::atomic<uint64_t> timeouts{0};
+  std::atomic<uint64_t> responses2xx{0};
+  std::atomic<uint64_t> responses3xx{0};
+  std::atomic<uint64_t> responses4xx{0};
+  std::atomic<uint64_t> responses5xx{0};
+
+  void count_status(int status);
+  std::string render(const ServerLimits& limits, size_t trackedClients) const;
+};
+
+// DB version, age and updater counters (`oui serve --update-interval`).
+std::string render_update(const update::BackgroundStatus& s);
+
+} // namespace web
@@ -0,0 +1,215 @@
+#include "web/stats.h"
+#include "oui/mac.h"
+#include "util/fs.h"
+#include "util/str.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+namespace web {
+
+static uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static size_t cell(uint64_t key, size_t row) {
+  return mix(key ^ (0x5851f42d4c957f2dULL * (row + 1))) & (LookupStats::kWidth - 1);
+}
+
+struct Sketch {
+  std::atomic<uint32_t> cells[LookupStats::kDepth][LookupStats::kWidth];
+
+  Sketch() {
+    for (auto& row : cells) {
+      for (auto& c : row) c.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Conservative update: only the smallest counters grow. Single writer.
+  uint32_t add(uint64_t key) {
+    size_t idx[LookupStats::kDepth];
+    uint32_t lo = UINT32_MAX;
+    for (size_t r = 0; r < LookupStats::kDepth; r++) {
+      idx[r] = cell(key, r);
+      lo = std::min(lo, cells[r][idx[r]].load(std::memory_order_relaxed));
+    }
+    if (lo == UINT32_MAX) return lo;
+    const uint32_t next = lo + 1;
+    for (size_t r = 0; r < LookupStats::kDepth; r++) {
+      if (cells[r][idx[r]].load(std::memory_order_relaxed) < next) {
+        cells[r][idx[r]].store(next, std::memory_order_relaxed);
+      }
+    }
+    return next;
+  }
+};
+
+// Keys whose estimate beats the smallest tracked one replace it
+// (space-saving over the sketch estimates).
+struct Heavy {
+  // Owner thread only.
+  std::unordered_map<uint64_t, size_t> slotOf;
+  std::vector<uint64_t> slotKey;
+  std::vector<uint32_t> estimate;
+  size_t minSlot = 0;
+
+  // Shared with readers; only touched when the key set changes.
+  std::mutex mu;
+  std::vector<std::pair<uint64_t, std::string>> keys;
+};
+
+struct LookupStats::Shard {
+  Sketch sketch[kKinds];
+  Heavy heavy[kKinds];
+  std::atomic<uint64_t> total{0};
+  std::atomic<uint64_t> misses{0};
+
+  template <typename Label>
+  void count(Kind kind, uint64_t key, Label&& label) {
+    const uint32_t est = sketch[kind].add(key);
+    Heavy& h = heavy[kind];
+    auto it = h.slotOf.find(key);
+    if (it != h.slotOf.end()) {
+      h.estimate[it->second] = est;
+      return;
+    }
+    if (h.slotKey.size() < kCandidates) {
+      std::lock_guard<std::mutex> lock(h.mu);
+      h.slotOf.emplace(key, h.slotKey.size());
+      h.slotKey.push_back(key);
+      h.estimate.push_back(est);
+      h.keys.emplace_back(key, label());
+      return;
+    }
+    if (est <= h.estimate[h.minSlot]) return;
+    // Estimates only grow, so the cached minimum may be stale; refresh it.
+    h.minSlot = static_cast<size_t>(std::min_element(h.estimate.begin(), h.estimate.end()) -
+                                    h.estimate.begin());
+    if (est <= h.estimate[h.minSlot]) return;
+
+    const size_t slot = h.minSlot;
+    std::lock_guard<std::mutex> lock(h.mu);
+    h.slotOf.erase(h.slotKey[slot]);
+    h.slotOf.emplace(key, slot);
+    h.slotKey[slot] = key;
+    h.estimate[slot] = est;
+    h.keys[slot] = {key, label()};
+  }
+};
+
+static std::atomic<uint64_t> g_nextStatsId{1};
+
+LookupStats::LookupStats() : id_(g_nextStatsId.fetch_add(1)) {}
+
+LookupStats::~LookupStats() = default;
+
+LookupStats::Shard& LookupStats::local() {
+  struct Cached {
+    uint64_t owner = 0;
+    Shard* shard = nullptr;
+  };
+  thread_local Cached cached;
+  if (cached.owner != id_) {
+    std::lock_guard<std::mutex> lock(mu_);
+    shards_.push_back(std::make_unique<Shard>());
+    cached = {id_, shards_.back().get()};
+  }
+  return *cached.shard;
+}
+
+void LookupStats::record(uint64_t mac, bool found, uint64_t prefix, int maskBits,
+                         const std::string& vendor) {
+  Shard& s = local();
+  s.total.store(s.total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  s.count(Mac, mac, [&] { return oui::prefix_to_string(mac, 48); });
+  if (!found) {
+    s.misses.store(s.misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return;
+  }
+  s.count(Oui, (prefix << 8) | static_cast<uint64_t>(maskBits), [&] {
+    return oui::prefix_to_string(prefix, maskBits) + "/" + std::to_string(maskBits);
+  });
+  s.count(Vendor, util::str::fnv1a64(vendor.data(), vendor.size()), [&] { return vendor; });
+}
+
+std::vector<LookupStats::Item> LookupStats::top(Kind kind, size_t n) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  std::unordered_map<uint64_t, std::string> candidates;
+  for (const auto& s : shards_) {
+    Heavy& h = s->heavy[kind];
+    std::lock_guard<std::mutex> hl(h.mu);
+    for (const auto& kv : h.keys) candidates.emplace(kv.first, kv.second);
+  }
+
+  // Summed sketches are a sketch of the combined stream.
+  std::vector<Item> items;
+  items.reserve(candidates.size());
+  for (auto& kv : candidates) {
+    uint64_t est = UINT64_MAX;
+    for (size_t r = 0; r < kDepth; r++) {
+      const size_t c = cell(kv.first, r);
+      uint64_t sum = 0;
+      for (const auto& s : shards_) sum += s->sketch[kind].cells[r][c].load(std::memory_order_relaxed);
+      est = std::min(est, sum);
+    }
+    items.push_back({std::move(kv.second), est});
+  }
+  std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+    return a.count != b.count ? a.count > b.count : a.key < b.key;
+  });
+  if (items.size() > n) items.resize(n);
+  return items;
+}
+
+uint64_t LookupStats::total() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  uint64_t n = 0;
+  for (const auto& s : shards_) n += s->total.load(std::memory_order_relaxed);
+  return n;
+}
+
+uint64_t LookupStats::misses() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  uint64_t n = 0;
+  for (const auto& s : shards_) n += s->misses.load(std::memory_order_relaxed);
+  return n;
+}
+
+util::json::Object LookupStats::to_json(size_t n) const {
+  using util::json::Value;
+  auto list = [&](Kind kind) {
+    util::json::Array out;
+    for (const auto& it : top(kind, n)) {
+      out.push_back(Value(util::json::Object{{"key", Value(it.key)},
+                                             {"count", Value(static_cast<int64_t>(it.count))}}));
+    }
+    return out;
+  };
+  util::json::Object obj;
+  obj["lookups"] = Value(static_cast<int64_t>(total()));
+  obj["misses"] = Value(static_cast<int64_t>(misses()));
+  obj["vendors"] = Value(list(Vendor));
+  obj["prefixes"] = Value(list(Oui));
+  obj["macs"] = Value(list(Mac));
+  return obj;
+}
+
+bool LookupStats::save(const std::string& path, size_t n) const {
+  const std::string body = util::json::stringify(to_json(n)) + "\n";
+  const std::string tmp = path + ".tmp";
+  std::FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) return false;
+  bool ok = std::fwrite(body.data(), 1, body.size(), f) == body.size();
+  ok = (std::fclose(f) == 0) && ok;
+  if (!ok || !util::fs::atomic_replace(tmp, path)) {
+    util::fs::remove_file(tmp);
+    return false;
+  }
+  return true;
+}
+
+} // namespace web
@@ -0,0 +1,60 @@
+#pragma once
+#include "util/json.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace web {
+
+// Approximate lookup frequencies in bounded memory. Every thread calling
+// record() gets its own shard: a count-min sketch and a small heavy-hitter
+// table per kind. Only the owner writes a shard's counters (relaxed atomics),
+// so the hot path takes no lock; readers merge all shards on demand.
+class LookupStats {
+public:
+  enum Kind { Mac, Oui, Vendor, kKinds };
+
+  struct Item {
+    std::string key;
+    uint64_t count = 0; // upper bound; exact unless sketch cells collide
+  };
+
+  static constexpr size_t kDepth = 4;
+  static constexpr size_t kWidth = 4096;     // per row; power of two
+  static constexpr size_t kCandidates = 128; // heavy hitters kept per kind and thread
+
+  LookupStats();
+  ~LookupStats();
+
+  LookupStats(const LookupStats&) = delete;
+  LookupStats& operator=(const LookupStats&) = delete;
+
+  // mac is the parsed query; prefix/maskBits/vendor describe the match if found.
+  void record(uint64_t mac, bool found, uint64_t prefix, int maskBits, const std::string& vendor);
+  // Sets up the calling thread's shard now rather than on its first record().
+  void warm() { local(); }
+
+  std::vector<Item> top(Kind kind, size_t n) const;
+  uint64_t total() const;
+  uint64_t misses() const;
+
+  util::json::Object to_json(size_t n) const;
+  // Writes to_json(n) to path via a temp file and rename.
+  bool save(const std::string& path, size_t n) const;
+
+private:
+  struct Shard;
+
+  const uint64_t id_; // distinguishes instances in the thread-local shard cache
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  Shard& local();
+};
+
+} // namespace web
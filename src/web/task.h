@@ -0,0 +1,99 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace web {
+
+// Lazily started coroutine. `co_await task` runs it and resumes the awaiting
+// coroutine when it finishes; the hand-over is a symmetric transfer, so long
+// chains of awaits do not grow the stack. Exceptions propagate to the awaiter.
+// Top-level tasks are handed to Executor::spawn(), which detaches them; a
+// detached task frees itself when it finishes.
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+  std::coroutine_handle<> continuation;
+  std::exception_ptr error;
+  bool detached = false;
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+      PromiseBase& p = h.promise();
+      if (p.continuation) return p.continuation;
+      if (p.detached) {
+        // Nobody is left to see it, same as an exception escaping a thread.
+        if (p.error) std::terminate();
+        h.destroy();
+      }
+      return std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter final_suspend() noexcept { return {}; }
+  void unhandled_exception() noexcept { error = std::current_exception(); }
+
+  void rethrow() {
+    if (error) std::rethrow_exception(error);
+  }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+  std::optional<T> value;
+  void return_value(T v) { value.emplace(std::move(v)); }
+  T result() {
+    rethrow();
+    return std::move(*value);
+  }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+  void return_void() {}
+  void result() { rethrow(); }
+};
+
+} // namespace detail
+
+template <typename T>
+class Task {
+public:
+  struct promise_type : detail::Promise<T> {
+    Task get_return_object() { return Task(Handle::from_promise(*this)); }
+  };
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Task(Task&& other) noexcept : h_(std::exchange(other.h_, {})) {}
+  Task& operator=(Task&&) = delete;
+  ~Task() {
+    if (h_) h_.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    h_.promise().continuation = awaiting;
+    return h_;
+  }
+  T await_resume() { return h_.promise().result(); }
+
+  // Gives up ownership; the frame then frees itself at the end (detached).
+  Handle detach() {
+    h_.promise().detached = true;
+    return std::exchange(h_, {});
+  }
+
+private:
+  explicit Task(Handle h) : h_(h) {}
+  Handle h_;
+};
+
+} // namespace web
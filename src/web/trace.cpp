@@ -0,0 +1,223 @@
+#include "web/trace.h"
+#include "util/fs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace web {
+
+static constexpr size_t kWords = sizeof(RequestTrace) / 8;
+
+static std::atomic<uint64_t> g_nextRecorderId{1};
+
+// Nanoseconds per trace tick, measured once against steady_clock.
+static double ns_per_tick() {
+#if defined(__x86_64__) || defined(__i386__)
+  static const double rate = [] {
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+    const uint64_t c0 = trace_ticks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto t1 = Clock::now();
+    const uint64_t c1 = trace_ticks();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(c1 - c0);
+  }();
+  return rate;
+#else
+  return 1.0;
+#endif
+}
+
+void RequestTrace::received(std::string_view req) {
+  if (!at[Accept]) return;
+  at[Read] = trace_ticks();
+  bytesIn = static_cast<uint32_t>(req.size());
+  // Raw bytes here; to_json() cuts at the line end and cleans them up.
+  const size_t n = std::min(req.size(), sizeof(input));
+  std::memcpy(input, req.data(), n);
+  inputLen = static_cast<uint8_t>(n);
+}
+
+// Request line from the raw input bytes, non-printables as '?'.
+static std::string request_line(const RequestTrace& t) {
+  std::string out;
+  for (size_t i = 0; i < t.inputLen && t.input[i] != '\r' && t.input[i] != '\n'; i++) {
+    const unsigned char c = static_cast<unsigned char>(t.input[i]);
+    out.push_back(c >= 0x20 && c < 0x7f ? static_cast<char>(c) : '?');
+  }
+  return out;
+}
+
+struct FlightRecorder::Ring {
+  struct Slot {
+    std::atomic<uint64_t> seq{0}; // 2k+1 while write k is in progress, 2k+2 after it
+    std::atomic<uint64_t> words[kWords];
+  };
+
+  explicit Ring(size_t n) : slots(n) {}
+
+  std::vector<Slot> slots;
+  std::atomic<uint64_t> written{0}; // written by the owner only
+
+  void push(const RequestTrace& t) {
+    const uint64_t k = written.load(std::memory_order_relaxed);
+    Slot& s = slots[k % slots.size()];
+    uint64_t w[kWords];
+    std::memcpy(w, &t, sizeof(w));
+    // Release on every word (a plain store on x86) keeps the odd seq ahead
+    // of the new contents without a fence.
+    s.seq.store(2 * k + 1, std::memory_order_relaxed);
+    for (size_t i = 0; i < kWords; i++) s.words[i].store(w[i], std::memory_order_release);
+    s.seq.store(2 * k + 2, std::memory_order_release);
+    written.store(k + 1, std::memory_order_relaxed);
+  }
+
+  // Appends every slot that was not being overwritten while it was read.
+  void collect(std::vector<RequestTrace>& out) const {
+    for (const Slot& s : slots) {
+      const uint64_t before = s.seq.load(std::memory_order_acquire);
+      if (before == 0 || (before & 1)) continue;
+      uint64_t w[kWords];
+      for (size_t i = 0; i < kWords; i++) w[i] = s.words[i].load(std::memory_order_acquire);
+      if (s.seq.load(std::memory_order_relaxed) != before) continue;
+      out.emplace_back();
+      std::memcpy(&out.back(), w, sizeof(w));
+    }
+  }
+};
+
+struct FlightRecorder::Shard {
+  Ring recent{kRecent};
+  Ring slow{kSlow};
+};
+
+FlightRecorder::FlightRecorder() : id_(g_nextRecorderId.fetch_add(1)) {}
+FlightRecorder::~FlightRecorder() = default;
+
+void FlightRecorder::set_threshold_us(int64_t thresholdUs) {
+  thresholdUs_ = thresholdUs;
+  thresholdTicks_ = thresholdUs < 0 ? kOff : static_cast<uint64_t>(thresholdUs * 1000 / ns_per_tick());
+}
+
+FlightRecorder::Shard& FlightRecorder::local() {
+  struct Cached {
+    uint64_t owner = 0;
+    Shard* shard = nullptr;
+  };
+  thread_local Cached cached;
+  if (cached.owner != id_) {
+    std::lock_guard<std::mutex> lock(mu_);
+    shards_.push_back(std::make_unique<Shard>());
+    cached = {id_, shards_.back().get()};
+  }
+  return *cached.shard;
+}
+
+static uint64_t last_stamp(const RequestTrace& t) {
+  uint64_t last = 0;
+  for (uint64_t at : t.at) last = std::max(last, at);
+  return last;
+}
+
+void FlightRecorder::record(const RequestTrace& t) {
+  if (!t.at[RequestTrace::Accept]) return;
+  Shard& s = local();
+  s.recent.push(t);
+  if (last_stamp(t) - t.at[RequestTrace::Accept] >= thresholdTicks_) s.slow.push(t);
+}
+
+static const char* outcome_name(RequestTrace::Outcome o) {
+  switch (o) {
+    case RequestTrace::Outcome::Sent: return "sent";
+    case RequestTrace::Outcome::ReadTimeout: return "read_timeout";
+    case RequestTrace::Outcome::WriteTimeout: return "write_timeout";
+    case RequestTrace::Outcome::WriteFailed: return "write_failed";
+  }
+  return "unknown";
+}
+
+util::json::Object FlightRecorder::to_json(size_t n) const {
+  using util::json::Value;
+  std::vector<RequestTrace> recent;
+  std::vector<RequestTrace> slow;
+  uint64_t recorded = 0;
+  uint64_t slowTotal = 0;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const auto& s : shards_) {
+      s->recent.collect(recent);
+      s->slow.collect(slow);
+      recorded += s->recent.written.load(std::memory_order_relaxed);
+      slowTotal += s->slow.written.load(std::memory_order_relaxed);
+    }
+  }
+
+  const double rate = ns_per_tick();
+  const uint64_t nowTicks = trace_ticks();
+  const int64_t nowUnixNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  auto ns = [&](uint64_t ticks) { return static_cast<int64_t>(static_cast<double>(ticks) * rate); };
+
+  static const char* const kStageNames[RequestTrace::kStages] = {
+    "accept", "read", "parse", "lookup", "serialize", "write"};
+  auto list = [&](std::vector<RequestTrace>& traces) {
+    std::sort(traces.begin(), traces.end(), [](const RequestTrace& a, const RequestTrace& b) {
+      return a.at[RequestTrace::Accept] > b.at[RequestTrace::Accept];
+    });
+    if (traces.size() > n) traces.resize(n);
+    util::json::Array out;
+    for (const RequestTrace& t : traces) {
+      const uint64_t start = t.at[RequestTrace::Accept];
+      // Time spent reaching each stage from the previous one it passed.
+      util::json::Object stages;
+      uint64_t prev = start;
+      for (int s = RequestTrace::Read; s < RequestTrace::kStages; s++) {
+        if (!t.at[s] || t.at[s] < prev) continue;
+        stages[kStageNames[s]] = Value(ns(t.at[s] - prev));
+        prev = t.at[s];
+      }
+      util::json::Object obj;
+      obj["start_unix_ms"] = Value((nowUnixNs - ns(nowTicks - start)) / 1000000);
+      obj["total_ns"] = Value(ns(last_stamp(t) - start));
+      obj["stages_ns"] = Value(stages);
+      obj["status"] = Value(static_cast<int>(t.status));
+      obj["outcome"] = Value(outcome_name(t.outcome));
+      obj["bytes_in"] = Value(static_cast<int64_t>(t.bytesIn));
+      obj["bytes_out"] = Value(static_cast<int64_t>(t.bytesOut));
+      obj["input"] = Value(request_line(t));
+      out.push_back(Value(obj));
+    }
+    return out;
+  };
+
+  util::json::Object obj;
+  obj["enabled"] = Value(enabled());
+  obj["threshold_us"] = Value(thresholdUs_);
+  obj["recorded"] = Value(static_cast<int64_t>(recorded));
+  obj["slow_total"] = Value(static_cast<int64_t>(slowTotal));
+  obj["slow"] = Value(list(slow));
+  obj["recent"] = Value(list(recent));
+  return obj;
+}
+
+bool FlightRecorder::dump(const std::string& path, size_t n) const {
+  const std::string body = util::json::stringify(to_json(n)) + "\n";
+  if (path.empty() || path == "-") {
+    return std::fwrite(body.data(), 1, body.size(), stderr) == body.size();
+  }
+  const std::string tmp = path + ".tmp";
+  std::FILE* f = std::fopen(tmp.c_str(), "wb");
+  if (!f) return false;
+  bool ok = std::fwrite(body.data(), 1, body.size(), f) == body.size();
+  ok = (std::fclose(f) == 0) && ok;
+  if (!ok || !util::fs::atomic_replace(tmp, path)) {
+    util::fs::remove_file(tmp);
+    return false;
+  }
+  return true;
+}
+
+} // namespace web
@@ -0,0 +1,116 @@
+#pragma once
+#include "util/json.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace web {
+
+// Raw timestamp for request tracing: the TSC on x86 (one instruction, no
+// vDSO call), steady_clock nanoseconds elsewhere. FlightRecorder converts
+// ticks to nanoseconds only when dumping.
+inline uint64_t trace_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// One request's timeline. Filled by the connection backend and respond_to()
+// on the worker's stack, then copied into the recorder; at[s] is 0 for
+// stages the request never reached. A trace whose Accept stamp is 0 was not
+// started (recording off) and stamps nothing.
+struct RequestTrace {
+  enum Stage {
+    Accept,    // connection accepted
+    Read,      // request bytes complete
+    Parse,     // request line, headers and cache validators handled
+    Lookup,    // DB answer ready (lookup routes only)
+    Serialize, // response bytes built
+    Write,     // response sent (or the send gave up)
+    kStages,
+  };
+  enum class Outcome : uint8_t { Sent, ReadTimeout, WriteTimeout, WriteFailed };
+
+  uint64_t at[kStages] = {};
+  uint32_t bytesIn = 0;
+  uint32_t bytesOut = 0;
+  uint16_t status = 0; // 0: no response
+  Outcome outcome = Outcome::Sent;
+  uint8_t inputLen = 0;
+  char input[68];      // first bytes of the request
+
+  void stamp(Stage s) {
+    if (at[Accept]) at[s] = trace_ticks();
+  }
+  // Read stamp, size and request line once the request bytes are in.
+  void received(std::string_view req);
+  // Write stamp once the response is out or the send gave up.
+  void sent(Outcome o, size_t bytes) {
+    if (!at[Accept]) return;
+    outcome = o;
+    bytesOut = static_cast<uint32_t>(bytes);
+    at[Write] = trace_ticks();
+  }
+};
+static_assert(sizeof(RequestTrace) % 8 == 0, "copied into the ring as 64-bit words");
+
+// Flight recorder for request tails. Every worker thread writes its own pair
+// of rings: the last kRecent requests and the last kSlow requests over the
+// threshold, so slow requests survive a flood of fast ones. A slot is a
+// seqlock over relaxed atomic words: the owner never waits and readers
+// (GET /debug/slow, SIGUSR1) skip slots torn by a concurrent write.
+class FlightRecorder {
+public:
+  static constexpr size_t kRecent = 512; // per thread
+  static constexpr size_t kSlow = 128;   // per thread
+
+  FlightRecorder();
+  ~FlightRecorder();
+
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  // Requests taking thresholdUs or more from accept to their last stamp go
+  // to the slow ring too. < 0 turns recording off (start() does nothing).
+  void set_threshold_us(int64_t thresholdUs);
+  bool enabled() const { return thresholdTicks_ != kOff; }
+
+  void start(RequestTrace& t) const {
+    if (enabled()) t.at[RequestTrace::Accept] = trace_ticks();
+  }
+  void record(const RequestTrace& t);
+
+  // Newest first: up to n slow requests and n recent ones, all threads.
+  util::json::Object to_json(size_t n) const;
+  // Writes to_json(n) to path via a temp file and rename; "" or "-" is stderr.
+  bool dump(const std::string& path, size_t n) const;
+
+private:
+  struct Ring;
+  struct Shard;
+  static constexpr uint64_t kOff = UINT64_MAX;
+
+  const uint64_t id_; // distinguishes instances in the thread-local shard cache
+  uint64_t thresholdTicks_ = kOff;
+  int64_t thresholdUs_ = -1;
+  mutable std::mutex mu_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  Shard& local();
+};
+
+} // namespace web
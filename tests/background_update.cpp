@@ -0,0 +1,174 @@
+// Background updates end to end, without a network: a file:// mirror feeds
+// a BackgroundUpdater that swaps versions under an HttpServer and a
+// UnixServer. Checks the swap (answers, ETags, the unix generation, the
+// persisted file), that bad or missing downloads keep the current version,
+// the /metrics export, the scheduled thread swapping while request threads
+// keep answering, and that the unix server ends its connection threads
+// before the handle goes. Build with -DOUI_SANITIZE=thread to check the swap
+// against the readers.
+#include "ipc/client.h"
+#include "ipc/unix_server.h"
+#include "oui/db_handle.h"
+#include "oui/manuf_db.h"
+#include "test_util.h"
+#include "update/background.h"
+#include "web/http_server.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using test::expect;
+using test::fail;
+
+std::string write_db(const test::TempDir& dir, const std::string& name, const std::string& vendor) {
+  return dir.write(name, "00:11:22\t" + vendor + "\n00:AA:BB\t" + vendor + "\n0C:0C:0C/28\t" + vendor + "\n");
+}
+
+std::string read_file(const std::string& path) {
+  std::ifstream in(path);
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+const char kLookup[] = "GET /api/lookup?mac=00:11:22:33:44:55 HTTP/1.1\r\nHost: x\r\n";
+
+std::string get(web::HttpServer& server, const std::string& head, const std::string& extra = "") {
+  return server.respond_to(head + extra + "\r\n", "127.0.0.1", true);
+}
+
+std::string etag_of(const std::string& resp) {
+  const size_t at = resp.find("ETag: ");
+  if (at == std::string::npos) return "";
+  return resp.substr(at + 6, resp.find("\r\n", at) - at - 6);
+}
+
+bool has_vendor(const std::string& resp, const std::string& vendor) {
+  return resp.find("\"" + vendor + "\"") != std::string::npos;
+}
+
+} // namespace
+
+int main() {
+  const test::TempDir dir("oui-update");
+  const std::string served = write_db(dir, "manuf", "V1");
+  const std::string mirror = write_db(dir, "mirror", "V2");
+
+  auto first = std::make_unique<oui::ManufDB>();
+  if (!first->load(served).ok) {
+    std::fprintf(stderr, "cannot load %s\n", served.c_str());
+    return 1;
+  }
+  oui::DbHandle handle(std::move(first));
+  web::HttpServer server("127.0.0.1", 0, served, &handle);
+  auto unixServer = std::make_unique<ipc::UnixServer>(dir.file("sock"), &handle);
+  std::string err;
+  expect(unixServer->start(err), "unix listener: " + err);
+  ipc::Client client(dir.file("sock"));
+  expect(client.connect(), "unix connect: " + client.last_error());
+  auto unix_vendor = [&] {
+    const uint64_t mac = 0x001122334455ULL;
+    ipc::Resolved r;
+    return client.resolve(&mac, 1, &r) && r.vendor ? *r.vendor : std::string("?");
+  };
+
+  update::BackgroundOptions opt;
+  opt.url = "file://" + mirror;
+  opt.dbPath = served;
+  opt.intervalSec = 1;
+  update::BackgroundUpdater updater(handle, opt);
+  updater.set_on_publish([&](uint64_t version, const std::string& tag) { server.set_db_tag(version, tag); });
+  server.set_updater(&updater);
+
+  const std::string before = get(server, kLookup);
+  const std::string tag1 = etag_of(before);
+  expect(has_vendor(before, "V1"), "initial answer");
+  expect(unix_vendor() == "V1", "initial unix answer");
+  expect(!tag1.empty(), "initial ETag");
+
+  // A new DB: swapped, persisted, and cached answers are invalidated.
+  update::UpdateResult r = updater.run_once();
+  expect(r.ok, "first update: " + r.message);
+  expect(handle.version() == 2, "version after update");
+  expect(read_file(served).find("V2") != std::string::npos, "new DB not written to dbPath");
+  const std::string after = get(server, kLookup);
+  const std::string tag2 = etag_of(after);
+  expect(has_vendor(after, "V2"), "answer after update");
+  expect(unix_vendor() == "V2", "unix answer after update");
+  expect(!tag2.empty() && tag2 != tag1, "ETag unchanged by the update");
+  expect(get(server, kLookup, "If-None-Match: " + tag1 + "\r\n").rfind("HTTP/1.1 200", 0) == 0,
+         "stale ETag still matches");
+  expect(get(server, kLookup, "If-None-Match: " + tag2 + "\r\n").rfind("HTTP/1.1 304", 0) == 0,
+         "current ETag does not match");
+
+  // Same contents again: nothing to swap.
+  r = updater.run_once();
+  expect(r.ok && r.message == "unchanged", "second update: " + r.message);
+  expect(handle.version() == 2, "unchanged DB was published");
+
+  // Broken and missing downloads keep the last good version, on disk too.
+  dir.write("mirror", "<html>not a manuf file</html>\n");
+  r = updater.run_once();
+  expect(!r.ok, "garbage download accepted");
+  ::unlink(mirror.c_str());
+  r = updater.run_once();
+  expect(!r.ok, "missing download accepted");
+  expect(handle.version() == 2, "failed update changed the version");
+  expect(has_vendor(get(server, kLookup), "V2"), "answer after failed updates");
+  expect(read_file(served).find("V2") != std::string::npos, "failed update touched dbPath");
+
+  update::BackgroundStatus st = updater.status();
+  expect(st.checks == 4 && st.swaps == 1 && st.failures == 2, "status counters");
+  expect(st.consecutiveFailures == 2 && !st.lastOk && st.lastSuccess > 0, "status after failures");
+  const std::string metrics = get(server, "GET /metrics HTTP/1.1\r\n");
+  expect(metrics.find("\noui_db_version 2\n") != std::string::npos, "metrics: version");
+  expect(metrics.find("\noui_update_failures_total 2\n") != std::string::npos, "metrics: failures");
+  expect(metrics.find("\noui_update_last_ok 0\n") != std::string::npos, "metrics: last ok");
+
+  // The scheduled thread swaps while requests keep coming.
+  write_db(dir, "mirror", "V3");
+  std::atomic<bool> done{false};
+  std::vector<std::thread> clients;
+  for (int t = 0; t < 3; t++) {
+    clients.emplace_back([&] {
+      bool sawNew = false;
+      while (!done.load()) {
+        const std::string resp = get(server, kLookup);
+        const bool isNew = has_vendor(resp, "V3");
+        if (!isNew && !has_vendor(resp, "V2")) fail("unexpected answer: " + resp.substr(0, 80));
+        if (sawNew && !isNew) fail("went back to the old version");
+        sawNew = sawNew || isNew;
+      }
+    });
+  }
+  updater.start();
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+  while (handle.version() < 3 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  done = true;
+  for (auto& t : clients) t.join();
+  updater.stop();
+  expect(handle.version() == 3, "scheduled update did not happen");
+  expect(updater.status().lastOk, "scheduled update failed: " + updater.status().lastMessage);
+
+  // The client is still connected; the server must end its connection
+  // thread (and that thread's handle reader) before the handle goes away.
+  unixServer.reset();
+  std::printf("%llu versions, %d failures\n", static_cast<unsigned long long>(handle.version()),
+              test::failures.load());
+  return test::result();
+}
@@ -0,0 +1,357 @@
+// Differential test for the lookup engines. Every way the tree can answer a
+// longest-prefix match (the hash index built by load(), the compiled image,
+// mapped and placed copies of it, the shared-memory cache, the C API batch
+// call, MergeCursor and DbHandle) must give the reference answer for:
+//   - every entry's first and last address and the addresses just outside,
+//   - every OUI swept block by block at its finest sub-allocation (down to
+//     /36), first/last/random address per block,
+//   - random MACs, uniform and inside random entries.
+// A synthetic DB with nested, odd-length, duplicated and host-bit prefixes
+// is also checked against a brute-force scan, so the reference itself is
+// tested. The real DB (argv[1], e.g. data/manuf) is optional.
+//   oui_test_differential [manuf] [random-count]
+#include "capi/oui.h"
+#include "oui/compiled_db.h"
+#include "oui/db_handle.h"
+#include "oui/mac.h"
+#include "oui/manuf_db.h"
+#include "oui/merge_cursor.h"
+#include "oui/placement.h"
+#include "oui/shm_cache.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kMax48 = 0xFFFFFFFFFFFFULL;
+
+using test::fail;
+
+struct Hit {
+  bool found = false;
+  uint64_t prefix = 0;
+  int maskBits = 0;
+  std::string vendor;
+  std::string comment;
+
+  bool operator==(const Hit& o) const {
+    if (found != o.found) return false;
+    return !found || (prefix == o.prefix && maskBits == o.maskBits && vendor == o.vendor &&
+                      comment == o.comment);
+  }
+};
+
+Hit from_entry(const oui::Entry& e) {
+  return {true, e.prefix, e.maskBits, e.vendor, e.comment};
+}
+
+Hit from_result(const oui::LookupResult& r) {
+  return r.found ? from_entry(r.entry) : Hit{};
+}
+
+Hit from_image(const oui::CompiledDB& img, const oui::ImageEntry* e) {
+  return e ? from_entry(img.to_entry(*e)) : Hit{};
+}
+
+Hit from_capi(const oui_result& r) {
+  if (!r.found) return {};
+  return {true, r.prefix, r.mask_bits, r.vendor, r.comment};
+}
+
+std::string describe(const Hit& h) {
+  if (!h.found) return "(none)";
+  return oui::prefix_to_string(h.prefix, h.maskBits) + "/" + std::to_string(h.maskBits) + " \"" +
+         h.vendor + "\" #\"" + h.comment + "\"";
+}
+
+using Run = std::function<bool(const std::vector<uint64_t>& macs, std::vector<Hit>& out)>;
+
+struct Engine {
+  const char* name;
+  Run run; // false: not available here, skipped
+};
+
+// Finest block size swept per OUI; longer masks are covered by the
+// per-entry boundary probes.
+constexpr int kSweepBits = 36;
+
+std::vector<uint64_t> probe_macs(const oui::CompiledDB& img, size_t randomCount, std::mt19937_64& rng) {
+  std::vector<uint64_t> macs;
+  std::map<uint64_t, int> finest; // OUI -> longest mask inside it
+  const oui::ImageEntry* entries = img.entries();
+  for (uint32_t i = 0; i < img.entry_count(); i++) {
+    const oui::ImageEntry& e = entries[i];
+    const uint64_t last = e.prefix | (~oui::mask48(e.maskBits) & kMax48);
+    macs.push_back(e.prefix);
+    macs.push_back(last);
+    if (e.prefix > 0) macs.push_back(e.prefix - 1);
+    if (last < kMax48) macs.push_back(last + 1);
+    if (e.maskBits >= 24) {
+      int& bits = finest[e.prefix >> 24];
+      bits = std::max(bits, std::min<int>(e.maskBits, kSweepBits));
+    }
+  }
+  for (const auto& [oui, bits] : finest) {
+    const uint64_t blockSpan = uint64_t(1) << (48 - bits);
+    const uint64_t blocks = uint64_t(1) << (bits - 24);
+    for (uint64_t b = 0; b < blocks; b++) {
+      const uint64_t first = (oui << 24) | (b * blockSpan);
+      macs.push_back(first);
+      macs.push_back(first + blockSpan - 1);
+      macs.push_back(first + rng() % blockSpan);
+    }
+  }
+  for (size_t i = 0; i < randomCount; i++) {
+    macs.push_back(rng() & kMax48);
+    if (img.entry_count() == 0) continue;
+    const oui::ImageEntry& e = entries[rng() % img.entry_count()];
+    macs.push_back(e.prefix | (rng() & ~oui::mask48(e.maskBits) & kMax48));
+  }
+  std::shuffle(macs.begin(), macs.end(), rng);
+  return macs;
+}
+
+// Compares every engine with the first one on macs.
+void compare(const std::string& label, const std::vector<Engine>& engines,
+             const std::vector<uint64_t>& macs) {
+  std::vector<Hit> want;
+  if (!engines.front().run(macs, want) || want.size() != macs.size()) {
+    fail(label + ": reference engine failed");
+    return;
+  }
+  const size_t hits = static_cast<size_t>(std::count_if(want.begin(), want.end(),
+                                                        [](const Hit& h) { return h.found; }));
+  std::printf("%s: %zu MACs, %zu hits\n", label.c_str(), macs.size(), hits);
+  for (size_t k = 1; k < engines.size(); k++) {
+    std::vector<Hit> got;
+    if (!engines[k].run(macs, got)) {
+      std::printf("  %-16s skipped\n", engines[k].name);
+      continue;
+    }
+    size_t bad = 0;
+    for (size_t i = 0; i < macs.size(); i++) {
+      if (i < got.size() && got[i] == want[i]) continue;
+      if (bad++ < 5) {
+        fail(label + ": " + engines[k].name + " " + oui::prefix_to_string(macs[i], 48) + " got " +
+             (i < got.size() ? describe(got[i]) : "nothing") + ", want " + describe(want[i]));
+      }
+    }
+    std::printf("  %-16s %s\n", engines[k].name, bad ? "MISMATCH" : "ok");
+    if (bad > 5) fail(label + ": " + engines[k].name + " " + std::to_string(bad) + " mismatches");
+  }
+}
+
+// Runs every engine over the DB at path against the hash index (or, when
+// given, against oracle first).
+void check_db(const std::string& label, const std::string& path, const std::string& dir,
+              size_t randomCount, const Engine* oracle) {
+  oui::ManufDB ref;
+  auto lr = ref.load(path);
+  if (!lr.ok) {
+    fail(label + ": load failed: " + lr.message);
+    return;
+  }
+  const auto image = ref.compiled();
+  std::mt19937_64 rng(0x5eed);
+  const std::vector<uint64_t> macs = probe_macs(*image, randomCount, rng);
+
+  auto each = [](auto&& fn) {
+    return [fn](const std::vector<uint64_t>& macs, std::vector<Hit>& out) {
+      out.clear();
+      out.reserve(macs.size());
+      for (uint64_t mac : macs) out.push_back(fn(mac));
+      return true;
+    };
+  };
+  auto via_db = [&](std::function<bool(oui::ManufDB&)> setup) -> Run {
+    return [&ref, setup, each](const std::vector<uint64_t>& macs, std::vector<Hit>& out) {
+      oui::ManufDB db = ref;
+      if (!setup(db)) return false;
+      return each([&](uint64_t mac) { return from_result(db.lookup(mac)); })(macs, out);
+    };
+  };
+
+  const std::string imgFile = dir + "/" + label + ".img";
+  if (!image->save(imgFile)) fail(label + ": cannot write " + imgFile);
+
+  std::vector<Engine> engines;
+  if (oracle) engines.push_back(*oracle);
+  engines.push_back({"hash", each([&](uint64_t mac) { return from_result(ref.lookup(mac)); })});
+  engines.push_back({"text", each([&](uint64_t mac) {
+    return from_result(ref.lookup(oui::prefix_to_string(mac, 48)));
+  })});
+  engines.push_back({"compiled", each([&](uint64_t mac) { return from_image(*image, image->find(mac)); })});
+  engines.push_back({"attached", via_db([&](oui::ManufDB& db) { return db.attach(image); })});
+  engines.push_back({"mapped", via_db([&](oui::ManufDB& db) {
+    return db.attach(oui::CompiledDB::open_file(imgFile));
+  })});
+  engines.push_back({"placed", via_db([&](oui::ManufDB& db) {
+    oui::PlacedImage pi = oui::place(*image, oui::Placement{});
+    return pi.ok && db.relocate(pi.image);
+  })});
+  engines.push_back({"cached", via_db([&](oui::ManufDB& db) {
+    // Another process may already have published this file (data/manuf).
+    auto stamp = oui::shm::stamp_of(path);
+    if (!stamp) return false;
+    auto shared = oui::shm::attach(path, *stamp);
+    if (!shared && oui::shm::publish(path, *stamp, *image)) {
+      shared = oui::shm::attach(path, *stamp);
+      oui::shm::remove(path);
+    }
+    return db.attach(shared);
+  })});
+  engines.push_back({"capi-batch", [&](const std::vector<uint64_t>& macs, std::vector<Hit>& out) {
+    oui_db* h = oui_open(path.c_str(), nullptr, 0);
+    if (!h) return false;
+    std::vector<oui_result> res(macs.size());
+    oui_lookup_batch(h, macs.data(), macs.size(), res.data());
+    out.clear();
+    for (const oui_result& r : res) out.push_back(from_capi(r));
+    oui_close(h);
+    return true;
+  }});
+  engines.push_back({"capi-compiled", [&](const std::vector<uint64_t>& macs, std::vector<Hit>& out) {
+    oui_db* h = oui_open_compiled(imgFile.c_str(), nullptr, 0);
+    if (!h) return false;
+    out.clear();
+    for (uint64_t mac : macs) {
+      oui_result r{};
+      oui_lookup_u64(h, mac, &r);
+      out.push_back(from_capi(r));
+    }
+    oui_close(h);
+    return true;
+  }});
+  engines.push_back({"cursor-sorted", [&](const std::vector<uint64_t>& macs, std::vector<Hit>& out) {
+    std::vector<size_t> order(macs.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return macs[a] < macs[b]; });
+    oui::MergeCursor cursor(*image);
+    out.assign(macs.size(), Hit{});
+    for (size_t i : order) out[i] = from_image(*image, cursor.find(macs[i]));
+    if (!cursor.sorted()) fail(label + ": cursor left sorted mode on sorted input");
+    return true;
+  }});
+  engines.push_back({"cursor-unsorted", [&](const std::vector<uint64_t>& macs, std::vector<Hit>& out) {
+    oui::MergeCursor cursor(*image);
+    out.clear();
+    for (uint64_t mac : macs) out.push_back(from_image(*image, cursor.find(mac)));
+    return true;
+  }});
+  engines.push_back({"db-handle", [&](const std::vector<uint64_t>& macs, std::vector<Hit>& out) {
+    oui::DbHandle handle(std::make_unique<oui::ManufDB>(ref));
+    auto reader = handle.reader();
+    out.clear();
+    for (uint64_t mac : macs) out.push_back(from_result(reader.lookup(mac)));
+    return true;
+  }});
+
+  compare(label, engines, macs);
+  ::unlink(imgFile.c_str());
+}
+
+// Synthetic manuf file plus the table it should load into (later lines win).
+struct Synthetic {
+  std::string text;
+  std::map<std::pair<int, uint64_t>, oui::Entry> table;
+};
+
+Synthetic make_synthetic(std::mt19937_64& rng) {
+  Synthetic s;
+  auto add = [&](uint64_t mac, int bits, const std::string& token, const std::string& vendor,
+                 const std::string& comment) {
+    s.text += token + "\t" + vendor + (comment.empty() ? "" : "\t# " + comment) + "\n";
+    oui::Entry e;
+    e.prefix = mac & oui::mask48(bits);
+    e.maskBits = bits;
+    e.vendor = vendor;
+    e.comment = comment;
+    s.table[{bits, e.prefix}] = e;
+  };
+  auto token = [](uint64_t mac, int bits, bool slash) {
+    return oui::prefix_to_string(mac, slash ? 48 : bits) + (slash ? "/" + std::to_string(bits) : "");
+  };
+
+  s.text += "# synthetic manuf for oui_test_differential\n\n";
+  // One OUI with every level nested inside the next.
+  const uint64_t nest = 0x001BC5000000ULL;
+  add(nest, 24, token(nest, 24, false), "Nest24", "");
+  add(nest | 0x100000, 28, token(nest | 0x100000, 28, true), "Nest28", "first");
+  add(nest | 0x123000, 36, token(nest | 0x123000, 36, true), "Nest36", "");
+  add(nest | 0x123400, 40, token(nest | 0x123400, 40, true), "Nest40", "");
+  add(nest | 0x123456, 48, token(nest | 0x123456, 48, false), "Nest48 Full Address", "exact");
+  // Host bits beyond the mask are dropped; a later duplicate wins.
+  add(nest | 0x1FFFFF, 28, token(nest | 0x1FFFFF, 28, true), "Nest28b", "redefined");
+  // Short and odd-length masks.
+  add(0x0A0000000000ULL, 8, token(0x0A0000000000ULL, 8, false), "Net8", "");
+  add(0x0B0C00000000ULL, 16, token(0x0B0C00000000ULL, 16, false), "Net16", "");
+  add(0x0B0C80000000ULL, 17, token(0x0B0C80000000ULL, 17, true), "Net17", "");
+  add(0x0D0E0F800000ULL, 25, token(0x0D0E0F800000ULL, 25, true), "Odd25", "");
+  add(0x0D0E0F810000ULL, 33, token(0x0D0E0F810000ULL, 33, true), "Odd33", "");
+  add(0x0D0E0F810008ULL, 45, token(0x0D0E0F810008ULL, 45, true), "Odd45", "");
+  add(0x0D0E0F810009ULL, 47, token(0x0D0E0F810008ULL, 47, true), "Odd47", "");
+
+  // Random OUIs with random sub-allocations.
+  const int kMasks[] = {25, 28, 28, 28, 32, 36, 36, 40, 44, 48};
+  for (int i = 0; i < 60; i++) {
+    const uint64_t oui = (rng() & 0xFEFFFF) | 0x020000; // distinct from the fixed ones
+    if (rng() % 3 == 0) add(oui << 24, 24, token(oui << 24, 24, false), "R" + std::to_string(i), "");
+    const int subs = static_cast<int>(rng() % 6);
+    for (int j = 0; j < subs; j++) {
+      const int bits = kMasks[rng() % (sizeof(kMasks) / sizeof(kMasks[0]))];
+      const uint64_t mac = (oui << 24) | (rng() & 0xFFFFFF);
+      const std::string vendor = "R" + std::to_string(i) + "-" + std::to_string(j) +
+                                 (j % 2 ? "\tLong Name, Inc." : "");
+      add(mac, bits, token(mac, bits, true), vendor, j % 3 == 0 ? "c" + std::to_string(j) : "");
+    }
+  }
+  return s;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const std::string realDb = argc > 1 ? argv[1] : "";
+  const size_t randomCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50000;
+
+  const test::TempDir tmp("oui-diff");
+  const std::string& dir = tmp.path();
+
+  std::mt19937_64 rng(7);
+  const Synthetic syn = make_synthetic(rng);
+  const std::string synPath = tmp.write("synthetic", syn.text);
+  const Engine oracle{"brute-force", [&](const std::vector<uint64_t>& macs, std::vector<Hit>& out) {
+    out.clear();
+    for (uint64_t mac : macs) {
+      Hit best;
+      for (const auto& [key, e] : syn.table) {
+        if ((mac & oui::mask48(e.maskBits)) == e.prefix && (!best.found || e.maskBits > best.maskBits)) {
+          best = from_entry(e);
+        }
+      }
+      out.push_back(best);
+    }
+    return true;
+  }};
+  check_db("synthetic", synPath, dir, 2000, &oracle);
+  ::unlink(synPath.c_str());
+
+  if (!realDb.empty()) {
+    if (oui::resolve_db_path(realDb).empty()) std::printf("%s: not found, skipped\n", realDb.c_str());
+    else check_db("manuf", oui::resolve_db_path(realDb), dir, randomCount, nullptr);
+  }
+  return test::result();
+}
@@ -0,0 +1,104 @@
+// Stand-in for libFuzzer's main() when the compiler has no -fsanitize=fuzzer
+// (configure with -DOUI_FUZZ=ON under clang for the real thing). Same command
+// line: files and directories are the corpus, each input is run once, then
+// -runs=N mutations of them (byte flips, inserts, deletes, splices) from a
+// fixed -seed, so a failure reproduces.
+//   oui_fuzz_parse_mac -runs=20000 tests/fuzz/corpus/parse_mac
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static void add_path(const std::string& path, std::vector<std::string>& corpus) {
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0) {
+    std::fprintf(stderr, "cannot read %s\n", path.c_str());
+    std::exit(1);
+  }
+  if (S_ISDIR(st.st_mode)) {
+    DIR* d = ::opendir(path.c_str());
+    while (dirent* e = d ? ::readdir(d) : nullptr) {
+      if (e->d_name[0] != '.') add_path(path + "/" + e->d_name, corpus);
+    }
+    if (d) ::closedir(d);
+    return;
+  }
+  std::ifstream in(path, std::ios::binary);
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  corpus.push_back(ss.str());
+}
+
+static void run(const std::string& input) {
+  LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+}
+
+// Bytes that matter to the parsers under test.
+static const char kTokens[] = ":-./#\t\r\n \0?&=%0aFf";
+
+static std::string mutate(std::string s, const std::vector<std::string>& corpus, std::mt19937_64& rng) {
+  const int steps = 1 + static_cast<int>(rng() % 4);
+  for (int i = 0; i < steps; i++) {
+    const size_t pos = s.empty() ? 0 : rng() % (s.size() + 1);
+    switch (rng() % 6) {
+      case 0:
+        if (pos < s.size()) s[pos] = static_cast<char>(s[pos] ^ (1 << (rng() % 8)));
+        break;
+      case 1:
+        s.insert(pos, 1, static_cast<char>(rng()));
+        break;
+      case 2:
+        s.insert(pos, 1, kTokens[rng() % (sizeof(kTokens) - 1)]);
+        break;
+      case 3:
+        if (pos < s.size()) s.erase(pos, 1 + rng() % (s.size() - pos));
+        break;
+      case 4: {
+        const std::string& other = corpus[rng() % corpus.size()];
+        const size_t from = other.empty() ? 0 : rng() % other.size();
+        s.insert(pos, other.substr(from, rng() % 16));
+        break;
+      }
+      default:
+        if (pos < s.size()) s.insert(pos, s.substr(pos, 1 + rng() % 8));
+        break;
+    }
+  }
+  return s.size() > 4096 ? s.substr(0, 4096) : s;
+}
+
+int main(int argc, char** argv) {
+  long runs = 0;
+  uint64_t seed = 1;
+  std::vector<std::string> corpus;
+  for (int i = 1; i < argc; i++) {
+    if (std::strncmp(argv[i], "-runs=", 6) == 0) runs = std::strtol(argv[i] + 6, nullptr, 10);
+    else if (std::strncmp(argv[i], "-seed=", 6) == 0) seed = std::strtoull(argv[i] + 6, nullptr, 10);
+    else if (argv[i][0] == '-') continue; // other libFuzzer flags
+    else add_path(argv[i], corpus);
+  }
+
+  for (const auto& input : corpus) run(input);
+  if (corpus.empty()) corpus.emplace_back();
+  std::mt19937_64 rng(seed);
+  // Mutants also seed later mutants, so inputs drift further from the corpus.
+  std::vector<std::string> pool = corpus;
+  for (long i = 0; i < runs; i++) {
+    std::string input = mutate(pool[rng() % pool.size()], corpus, rng);
+    run(input);
+    if (pool.size() < 4096) pool.push_back(std::move(input));
+    else pool[rng() % pool.size()] = std::move(input);
+  }
+  std::printf("Done %zu inputs + %ld runs\n", corpus.size(), runs);
+  return 0;
+}
@@ -0,0 +1,45 @@
+// libFuzzer entry point for the HTTP request handler: the raw bytes of one
+// request go through HttpServer::respond_to(), exactly as a connection
+// backend hands them over. The answer must always be a complete response.
+#include "oui/manuf_db.h"
+#include "web/http_server.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+
+static void check(bool ok) {
+  if (!ok) std::abort();
+}
+
+static web::HttpServer& server() {
+  static oui::ManufDB db;
+  static std::unique_ptr<web::HttpServer> srv = [] {
+    char path[] = "/tmp/oui-fuzz-http-XXXXXX";
+    const int fd = ::mkstemp(path);
+    if (fd >= 0) ::close(fd);
+    {
+      std::ofstream out(path);
+      out << "00:1B:C5\tNest24\n"
+          << "00:1B:C5:10:00:00/28\tNest28\t# sub\n"
+          << "00:1B:C5:12:30:00/36\tNest36\tNest 36, Inc.\n"
+          << "0A/8\tNet8\n";
+    }
+    if (!db.load(path).ok) std::abort();
+    ::unlink(path);
+    return std::make_unique<web::HttpServer>("127.0.0.1", 0, "fuzz", &db);
+  }();
+  return *srv;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const std::string req(reinterpret_cast<const char*>(data), size);
+  const std::string resp = server().respond_to(req, "fuzz", true);
+  check(resp.rfind("HTTP/1.1 ", 0) == 0);
+  check(resp.find("\r\n\r\n") != std::string::npos);
+  return 0;
+}
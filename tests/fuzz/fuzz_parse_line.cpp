@@ -0,0 +1,36 @@
+// libFuzzer entry point for oui::parse_line, fed one input line at a time
+// like ManufDB::load(). A parsed entry must have a valid mask, no host bits
+// and a trimmed, non-empty vendor without the comment.
+#include "oui/mac.h"
+#include "oui/manuf_db.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+static void check(bool ok) {
+  if (!ok) std::abort();
+}
+
+static bool trimmed(std::string_view s) {
+  auto space = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+  return s.empty() || (!space(s.front()) && !space(s.back()));
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  std::string_view in(reinterpret_cast<const char*>(data), size);
+  oui::Entry e;
+  while (!in.empty()) {
+    const size_t nl = in.find('\n');
+    const std::string_view line = in.substr(0, nl);
+    in = nl == std::string_view::npos ? std::string_view() : in.substr(nl + 1);
+
+    bool hostBits = false;
+    if (oui::parse_line(line, e, hostBits) != oui::LineParse::Ok) continue;
+    check(e.maskBits >= 0 && e.maskBits <= 48);
+    check((e.prefix & ~oui::mask48(e.maskBits)) == 0);
+    check(!e.vendor.empty() && trimmed(e.vendor) && e.vendor.find('#') == std::string_view::npos);
+    check(trimmed(e.comment));
+  }
+  return 0;
+}
@@ -0,0 +1,34 @@
+// libFuzzer entry point for oui::parse_mac_or_prefix / parse_prefix. Any
+// accepted input must be a 48-bit value with nothing below its length, and
+// print back to something that parses to the same prefix.
+#include "oui/mac.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+static void check(bool ok) {
+  if (!ok) std::abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  const std::string_view in(reinterpret_cast<const char*>(data), size);
+
+  if (auto mp = oui::parse_mac_or_prefix(in)) {
+    check(mp->bitsHint >= 8 && mp->bitsHint <= 48 && mp->bitsHint % 8 == 0);
+    check((mp->mac48 & ~oui::mask48(mp->bitsHint)) == 0);
+    auto again = oui::parse_mac_or_prefix(oui::prefix_to_string(mp->mac48, mp->bitsHint));
+    check(again && again->mac48 == mp->mac48 && again->bitsHint == mp->bitsHint);
+  }
+
+  if (auto mp = oui::parse_prefix(in)) {
+    check(mp->bitsHint >= 0 && mp->bitsHint <= 48);
+    check((mp->mac48 & ~oui::mask48(mp->bitsHint)) == 0);
+    const std::string text =
+      oui::prefix_to_string(mp->mac48, mp->bitsHint) + "/" + std::to_string(mp->bitsHint);
+    auto again = oui::parse_prefix(text);
+    check(again && again->mac48 == mp->mac48 && again->bitsHint == mp->bitsHint);
+  }
+  return 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+// Scaffolding shared by the ctest programs: a failure counter that prints
+// the first few messages, and a scratch directory for generated DB files.
+#include <dirent.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+namespace test {
+
+inline std::atomic<int> failures{0};
+constexpr int kMaxReported = 20;
+
+// Counts a failure; only the first kMaxReported are printed. Thread-safe.
+inline void fail(const std::string& msg) {
+  if (failures.fetch_add(1) < kMaxReported) std::fprintf(stderr, "FAIL: %s\n", msg.c_str());
+}
+
+inline void expect(bool cond, const std::string& msg) {
+  if (!cond) fail(msg);
+}
+
+// Exit status for main().
+inline int result() {
+  if (failures.load() == 0) return 0;
+  std::fprintf(stderr, "%d failures\n", failures.load());
+  return 1;
+}
+
+// A fresh /tmp/<prefix>-XXXXXX directory, removed with its files when the
+// object goes away. Exits the test if it cannot be created.
+class TempDir {
+public:
+  explicit TempDir(const char* prefix) {
+    std::string tmpl = std::string("/tmp/") + prefix + "-XXXXXX";
+    if (!::mkdtemp(&tmpl[0])) {
+      std::perror("mkdtemp");
+      std::exit(1);
+    }
+    path_ = tmpl;
+  }
+  ~TempDir() {
+    if (DIR* d = ::opendir(path_.c_str())) {
+      while (dirent* e = ::readdir(d)) {
+        if (e->d_name[0] != '.') ::unlink(file(e->d_name).c_str());
+      }
+      ::closedir(d);
+    }
+    ::rmdir(path_.c_str());
+  }
+
+  TempDir(const TempDir&) = delete;
+  TempDir& operator=(const TempDir&) = delete;
+
+  const std::string& path() const { return path_; }
+  std::string file(const std::string& name) const { return path_ + "/" + name; }
+  // Writes text (e.g. manuf lines) to name, replacing it; returns the path.
+  std::string write(const std::string& name, const std::string& text) const {
+    const std::string p = file(name);
+    std::ofstream out(p, std::ios::trunc);
+    out << text;
+    if (!out) fail("cannot write " + p);
+    return p;
+  }
+
+private:
+  std::string path_;
+};
+
+} // namespace test
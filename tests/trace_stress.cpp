@@ -0,0 +1,95 @@
+// Writers fill the flight recorder while a reader keeps dumping it. Every
+// trace carries its sequence number in three places (bytes in, bytes out and
+// the request line), so a dumped entry where they disagree was read torn
+// from a slot being overwritten. Build with -DOUI_SANITIZE=thread to check
+// the seqlock itself.
+#include "test_util.h"
+#include "web/trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace {
+
+using test::fail;
+
+int64_t as_int(const util::json::Value& v) {
+  if (auto* i = std::get_if<int64_t>(&v.v)) return *i;
+  if (auto* i = std::get_if<int>(&v.v)) return *i;
+  fail("not an integer");
+  return -1;
+}
+
+// Checks every entry of one dumped list; returns how many there were.
+size_t check_list(const util::json::Object& dump, const char* name) {
+  auto it = dump.find(name);
+  if (it == dump.end()) {
+    fail(std::string("missing ") + name);
+    return 0;
+  }
+  const auto& list = std::get<util::json::Array>(it->second.v);
+  for (const auto& v : list) {
+    const auto& e = std::get<util::json::Object>(v.v);
+    const int64_t in = as_int(e.at("bytes_in"));
+    const int64_t out = as_int(e.at("bytes_out"));
+    const std::string& input = std::get<std::string>(e.at("input").v);
+    if (in != out || input != "GET /" + std::to_string(in) + " HTTP/1.1") {
+      fail(std::string(name) + ": torn entry " + std::to_string(in) + "/" + std::to_string(out) +
+           " " + input);
+    }
+  }
+  return list.size();
+}
+
+} // namespace
+
+int main() {
+  const int kWriters = 4;
+  const uint32_t kPerWriter = 200000;
+  web::FlightRecorder rec;
+  rec.set_threshold_us(0); // every request also goes to the slow ring
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kWriters; w++) {
+    writers.emplace_back([&, w] {
+      for (uint32_t k = 0; k < kPerWriter; k++) {
+        const uint32_t seq = static_cast<uint32_t>(w) * kPerWriter + k;
+        const std::string req = "GET /" + std::to_string(seq) + " HTTP/1.1\r\nHost: x\r\n\r\n";
+        web::RequestTrace t;
+        rec.start(t);
+        t.received(req);
+        t.stamp(web::RequestTrace::Parse);
+        t.bytesIn = seq;
+        t.sent(web::RequestTrace::Outcome::Sent, seq);
+        rec.record(t);
+      }
+    });
+  }
+
+  size_t dumps = 0;
+  std::thread reader([&] {
+    while (!done.load()) {
+      const util::json::Object dump = rec.to_json(64);
+      check_list(dump, "recent");
+      check_list(dump, "slow");
+      dumps++;
+    }
+  });
+  for (auto& t : writers) t.join();
+  done = true;
+  reader.join();
+
+  const util::json::Object dump = rec.to_json(SIZE_MAX);
+  if (as_int(dump.at("recorded")) != int64_t(kWriters) * kPerWriter) fail("recorded count");
+  if (check_list(dump, "recent") != kWriters * web::FlightRecorder::kRecent) fail("recent ring size");
+  if (check_list(dump, "slow") != kWriters * web::FlightRecorder::kSlow) fail("slow ring size");
+
+  std::printf("%d writers x %u traces, %zu concurrent dumps, %d failures\n", kWriters, kPerWriter,
+              dumps, test::failures.load());
+  return test::result();
+}